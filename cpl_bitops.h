@@ -0,0 +1,78 @@
+#ifndef __CPL_BITOPS_H__
+#define __CPL_BITOPS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+
+/*
+ * 功能：计算value末尾连续0的个数，value不能为0。
+ * 返回值：末尾0的个数。
+ */
+static inline unsigned int CplCtz64(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_ctzll(value);
+#else
+    unsigned int n = 0;
+
+    while (!(value & 1)) {
+        value >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/*
+ * 功能：计算value开头连续0的个数，value不能为0。
+ * 返回值：开头0的个数。
+ */
+static inline unsigned int CplClz64(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_clzll(value);
+#else
+    unsigned int n = 0;
+
+    while (!(value & ((uint64_t)1 << 63))) {
+        value <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/*
+ * 功能：查找value中最高的为1的比特位，value不能为0。
+ * 返回值：最高的为1的比特位索引，即value以2为底的对数向下取整。
+ */
+static inline unsigned int CplFls64(uint64_t value)
+{
+    return 63 - CplClz64(value);
+}
+
+/*
+ * 功能：计算value中为1的比特位个数。
+ * 返回值：为1的比特位个数。
+ */
+static inline unsigned int CplPopcount64(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_popcountll(value);
+#else
+    unsigned int n = 0;
+
+    for (; value; value &= value - 1)
+        n++;
+    return n;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__CPL_BITOPS_H__*/
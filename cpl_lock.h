@@ -0,0 +1,69 @@
+#ifndef __CPL_LOCK_H__
+#define __CPL_LOCK_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*定义后内存管理器是线程安全的，每个线性容器和动态容器管理器各使用一把锁。*/
+//#define MEM_MAN_THREAD_SAFE
+
+#ifdef MEM_MAN_THREAD_SAFE
+#include "pthread.h"
+
+typedef pthread_mutex_t CplLock;
+
+static inline void CplLockInit(CplLock *lock)
+{
+    pthread_mutex_init(lock, NULL);
+}
+
+static inline void CplLockAcquire(CplLock *lock)
+{
+    pthread_mutex_lock(lock);
+}
+
+static inline void CplLockRelease(CplLock *lock)
+{
+    pthread_mutex_unlock(lock);
+}
+#else
+typedef char CplLock;
+
+static inline void CplLockInit(CplLock *lock)
+{
+    (void)lock;
+}
+
+static inline void CplLockAcquire(CplLock *lock)
+{
+    (void)lock;
+}
+
+static inline void CplLockRelease(CplLock *lock)
+{
+    (void)lock;
+}
+#endif
+
+/*线程局部存储*/
+#if defined(__GNUC__) || defined(__clang__)
+#define CPL_THREAD_LOCAL        __thread
+#else
+#define CPL_THREAD_LOCAL        _Thread_local
+#endif
+
+/*原子操作，用于无锁数据结构。*/
+#define CplAtomicLoad(ptr)                      __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define CplAtomicStore(ptr, val)                __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define CplAtomicCas(ptr, pExpected, desired)   __atomic_compare_exchange_n((ptr), (pExpected), (desired), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define CplAtomicExchange(ptr, val)             __atomic_exchange_n((ptr), (val), __ATOMIC_ACQ_REL)
+#define CplAtomicFetchOr(ptr, val)              __atomic_fetch_or((ptr), (val), __ATOMIC_ACQ_REL)
+#define CplAtomicFetchAnd(ptr, val)             __atomic_fetch_and((ptr), (val), __ATOMIC_ACQ_REL)
+#define CplAtomicFetchAdd(ptr, val)             __atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__CPL_LOCK_H__*/
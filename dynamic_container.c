@@ -13,22 +13,49 @@
 #include "string.h"
 #include "errno.h"
 #include "cpl_debug.h"
+#include "cpl_bitops.h"
+#include "time.h"
+#include "stdlib.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include "unistd.h"
+#include "sys/mman.h"
+#endif
 
 //#define DCM_DEBUG
+/*定义后默认检查级别为DCM_CHECK_CHECKSUM，否则为DCM_CHECK_MARKER，运行时可通过DCMSetCheckLevel修改。*/
 //#define DCM_CHECKSUM
 
+#ifdef DCM_CHECKSUM
+#define DCM_DEFAULT_CHECK_LEVEL     DCM_CHECK_CHECKSUM
+#else
+#define DCM_DEFAULT_CHECK_LEVEL     DCM_CHECK_MARKER
+#endif
+
 #ifdef DCM_DEBUG
 #define PrDbg(...)          Pr("", __LINE__, __FUNCTION__, "debug", __VA_ARGS__)
 #else
 #define PrDbg(...)
 #endif
 
+/*
+ * 块的布局：
+ *      空闲块：[左边界标记][前向节点指针]...[后向节点指针][右边界标记]
+ *      已分配块：[左边界标记][用户数据.......................]
+ *      树容器中的空闲块：[左边界标记][前向节点指针][树节点]...[后向节点指针][右边界标记]
+ *      DCM_OOL_META模式下的空闲块：[左边界标记][元数据表项指针]......[右边界标记]
+ * 已分配块不保存右边界标记，右相邻块左边界标记中的prevUsed标志记录左相邻块是否被使用，
+ * 只有prevUsed为0时才能读取左相邻块的右边界标记进行合并。
+ * 容器链表和字典树中的节点：块内模式下是块的前向节点指针的地址，DCM_OOL_META模式下是块的元数据表项。
+ */
+
 /*边界标记长度*/
 #define BOUNDARY_MARKER_SIZE                            8
 /*块节点指针长度*/
 #define CHUNK_POINT_SIZE                                8
-/*块的最小长度*/
+/*块的最小长度，空闲块需要容纳左右边界标记和前后节点指针。*/
 #define CHUNK_MIN_SIZE                                  (BOUNDARY_MARKER_SIZE * 2 + CHUNK_POINT_SIZE * 2)
+/*块的最大长度，受边界标记中chunkSize的位数限制。*/
+#define CHUNK_MAX_SIZE                                  ((((uint64_t)1) << DCM_SIZE_BITS) - MEM_MAN_ALIGN_SIZE)
 
 /*对块尺寸进行向下/上取整，是MEM_MAN_ALIGN_SIZE的整数倍。*/
 #define CHUNK_SIZE_ROUND_DOWN(chunk_size)               ((chunk_size) / MEM_MAN_ALIGN_SIZE * MEM_MAN_ALIGN_SIZE)
@@ -39,9 +66,9 @@
 /*块地址对齐MEM_MAN_ALIGN_SIZE后的地址*/
 #define CHUNK_ALIGN_ADDR(chunk_addr)                    ((uint8_t *)(chunk_addr) + CHUNK_ALIGN_OFFSET(chunk_addr))
 
-/*块大小和窗口大小之间的互相转换*/
-#define CHUNK_SIZE_TO_HOLE_SIZE(chunk_size)             ((chunk_size) - BOUNDARY_MARKER_SIZE * 2)
-#define HOLE_SIZE_TO_CHUNK_SIZE(hole_size)              ((hole_size) + BOUNDARY_MARKER_SIZE * 2)
+/*块大小和窗口大小之间的互相转换，窗口为块被分配后可供使用的区域。*/
+#define CHUNK_SIZE_TO_HOLE_SIZE(chunk_size)             ((chunk_size) - BOUNDARY_MARKER_SIZE)
+#define HOLE_SIZE_TO_CHUNK_SIZE(hole_size)              ((hole_size) + BOUNDARY_MARKER_SIZE)
 
 /*块的窗口大小*/
 #define CHUNK_HOLE_SIZE(chunk_base)                     (CHUNK_SIZE_TO_HOLE_SIZE(BASE_TO_LMARKER(chunk_base)->chunkSize))
@@ -58,29 +85,65 @@
 #define LPOINTER_TO_BASE(l_pointer)                     ((uint8_t *)(l_pointer) - BOUNDARY_MARKER_SIZE)
 #define RPOINTER_TO_BASE(r_pointer)                     (RMARKER_TO_BASE((DCMBoundaryMarker *)((uint8_t *)(r_pointer) + CHUNK_POINT_SIZE)))
 
-/*块校验数据区地址和长度*/
-#define CHUNK_CS_DATA_ADDR(chunk_base)                  ((uint8_t *)BASE_TO_LPOINTER(chunk_base) + CHUNK_POINT_SIZE)
-#define CHUNK_CS_DATA_LEN(chunk_base)                   (BASE_TO_LMARKER(chunk_base)->chunkSize - BOUNDARY_MARKER_SIZE * 2 - CHUNK_POINT_SIZE * 2)
-
 /*读写块指针*/
 #define CHUNK_POINTER_DEREF_R(pointer)                  (*(void **)(pointer))
 #define CHUNK_POINTER_DEREF_W(pointer, val)             (*(void **)(pointer) = (val))
 
+#ifdef DCM_TREE
+/*树容器中的块，窗口尺寸不小于pow(2, DCM_TREE_MIN_LOG2)。*/
+#define CHUNK_IS_TREE(chunk_size)                       (CHUNK_SIZE_TO_HOLE_SIZE(chunk_size) >= ((size_t)1 << DCM_TREE_MIN_LOG2))
+#endif
+
+#ifdef DCM_OOL_META
+/*获取块的节点，即左边界标记之后保存的元数据表项指针，孤立块为NULL。*/
+#define CHUNK_NODE(chunk_base)                          ((DCMMeta *)CHUNK_POINTER_DEREF_R(BASE_TO_LPOINTER(chunk_base)))
+#define CHUNK_SET_NODE(chunk_base, node)                (CHUNK_POINTER_DEREF_W(BASE_TO_LPOINTER(chunk_base), (node)))
+/*节点和块基址之间的转换*/
+#define NODE_TO_CHUNK(node)                             (((DCMMeta *)(node))->base)
+/*读写节点的前向/后向节点*/
+#define NODE_GET_PREV(node)                             (((DCMMeta *)(node))->prev)
+#define NODE_GET_NEXT(node)                             (((DCMMeta *)(node))->next)
+#define NODE_SET_PREV(node, val)                        (((DCMMeta *)(node))->prev = (val))
+#define NODE_SET_NEXT(node, val)                        (((DCMMeta *)(node))->next = (val))
+/*节点对应的块的窗口尺寸*/
+#define NODE_HOLE_SIZE(node)                            (CHUNK_SIZE_TO_HOLE_SIZE(((DCMMeta *)(node))->chunkSize))
+/*节点的树节点*/
+#define NODE_TO_TNODE(node)                             (&((DCMMeta *)(node))->tree)
+/*树节点保存在元数据表项中，不占用块内空间。*/
+#define CHUNK_TREE_SIZE(chunk_base)                     0
+#else
+#define CHUNK_NODE(chunk_base)                          (BASE_TO_LPOINTER(chunk_base))
+#define NODE_TO_CHUNK(node)                             LPOINTER_TO_BASE(node)
+#define NODE_GET_PREV(node)                             (CHUNK_POINTER_DEREF_R(node))
+#define NODE_GET_NEXT(node)                             (CHUNK_POINTER_DEREF_R(BASE_TO_RPOINTER(NODE_TO_CHUNK(node))))
+#define NODE_SET_PREV(node, val)                        (CHUNK_POINTER_DEREF_W(node, (val)))
+#define NODE_SET_NEXT(node, val)                        (CHUNK_POINTER_DEREF_W(BASE_TO_RPOINTER(NODE_TO_CHUNK(node)), (val)))
+#define NODE_HOLE_SIZE(node)                            (CHUNK_HOLE_SIZE(NODE_TO_CHUNK(node)))
+/*树节点位于前向节点指针之后。*/
+#define NODE_TO_TNODE(node)                             ((DCMTreeNode *)((uint8_t *)(node) + CHUNK_POINT_SIZE))
+#ifdef DCM_TREE
+/*空闲块中树节点占用的尺寸*/
+#define CHUNK_TREE_SIZE(chunk_base)                     (CHUNK_IS_TREE(BASE_TO_LMARKER(chunk_base)->chunkSize) ? sizeof (DCMTreeNode) : 0)
+#else
+#define CHUNK_TREE_SIZE(chunk_base)                     0
+#endif
+#endif
+
+/*块校验数据区地址和长度，不包含节点指针和树节点。*/
+#define CHUNK_CS_DATA_ADDR(chunk_base)                  ((uint8_t *)BASE_TO_LPOINTER(chunk_base) + CHUNK_POINT_SIZE + CHUNK_TREE_SIZE(chunk_base))
+#define CHUNK_CS_DATA_LEN(chunk_base)                   (BASE_TO_LMARKER(chunk_base)->chunkSize - BOUNDARY_MARKER_SIZE * 2 - CHUNK_POINT_SIZE * 2 - CHUNK_TREE_SIZE(chunk_base))
+
 /*设置块的前向/后向节点*/
-#define CHUNK_SET_PREV_NODE(chunk_base, next)           (CHUNK_POINTER_DEREF_W(BASE_TO_LPOINTER(chunk_base), (next)))
-#define CHUNK_SET_NEXT_NODE(chunk_base, next)           (CHUNK_POINTER_DEREF_W(BASE_TO_RPOINTER(chunk_base), (next)))
+#define CHUNK_SET_PREV_NODE(chunk_base, next)           NODE_SET_PREV(CHUNK_NODE(chunk_base), (next))
+#define CHUNK_SET_NEXT_NODE(chunk_base, next)           NODE_SET_NEXT(CHUNK_NODE(chunk_base), (next))
 
 /*读取块的前/后向节点*/
-#define CHUNK_GET_PREV_NODE(chunk_base)                 (CHUNK_POINTER_DEREF_R(BASE_TO_LPOINTER(chunk_base)))
-#define CHUNK_GET_NEXT_NODE(chunk_base)                 (CHUNK_POINTER_DEREF_R(BASE_TO_RPOINTER(chunk_base)))
+#define CHUNK_GET_PREV_NODE(chunk_base)                 NODE_GET_PREV(CHUNK_NODE(chunk_base))
+#define CHUNK_GET_NEXT_NODE(chunk_base)                 NODE_GET_NEXT(CHUNK_NODE(chunk_base))
 
-/*获取块/容器节点地址*/
-#define CHUNK_NODE(chunk_base)                          (BASE_TO_LPOINTER(chunk_base))
+/*获取容器节点地址*/
 #define CONTAINER_NODE(container)                       ((void)((DCMContainer *)NULL == container), (void *)container)
 
-/*块节点和基地址之间的转换*/
-#define NODE_TO_CHUNK(node)                             LPOINTER_TO_BASE(node)
-
 /*左边相邻块的右边界标记*/
 #define CHUNK_LNB_RMARKER(chunk_base)                   ((DCMBoundaryMarker *)((uint8_t *)(chunk_base) - BOUNDARY_MARKER_SIZE))
 /*右边相邻块的左边界标记*/
@@ -90,12 +153,35 @@
 
 /*边界标记，用于管理一个块。*/
 typedef struct {
-    uint32_t used: 1;           /*块是否被使用，0：未使用，1：已使用*/
-    uint32_t checksum: 16;      /*校验信息*/
-    uint32_t chunkSize;         /*块大小。*/
+    uint64_t used: 1;           /*块是否被使用，0：未使用，1：已使用*/
+    uint64_t prevUsed: 1;       /*左相邻块是否被使用，只在左边界标记中有效*/
+    uint64_t zeroed: 1;         /*块中除边界标记和节点指针以外的内容全为0，只在左边界标记中有效*/
+    uint64_t checksum: 16;      /*校验信息*/
+    uint64_t chunkSize: DCM_SIZE_BITS;  /*块大小。*/
 } DCMBoundaryMarker;
 
-#ifdef DCM_CHECKSUM
+#ifdef DCM_TREE
+/*树容器中空闲块的按位字典树节点。从根节点开始，第d层的块按窗口尺寸中从最高位往下第d个比特位选择子节点，
+    同尺寸的块只有一个位于树中，其余的重复块在容器链表中紧随其后。*/
+typedef struct {
+    void *parent;               /*父节点，根节点指向容器，重复块为NULL*/
+    void *child[2];             /*子节点*/
+} DCMTreeNode;
+#endif
+
+#ifdef DCM_OOL_META
+/*空闲块的元数据表项，保存在从堆区分配的元数据页中，遍历容器时只访问表项。空闲表项通过next串成链表。*/
+typedef struct {
+    void *prev;                 /*容器链表中的前向节点*/
+    void *next;                 /*容器链表中的后向节点*/
+    uint8_t *base;              /*块基址，空闲表项为NULL*/
+    size_t chunkSize;           /*块大小*/
+#ifdef DCM_TREE
+    DCMTreeNode tree;           /*字典树节点*/
+#endif
+} DCMMeta;
+#endif
+
 /*
  * 功能：生成buffer区的校验和
  * 返回值：
@@ -110,7 +196,18 @@ static uint16_t DCMGenChecksum(uint8_t *buffer, size_t size)
     }
     return checksum;
 }
-#endif
+
+/*
+ * 功能：按照当前检查级别计算空闲块边界标记中应保存的校验信息
+ * 返回值：校验信息
+ **/
+static inline uint16_t DCMChunkChecksum(DynamicCtnMan *dcm, uint8_t *chunkBase)
+{
+    if (dcm->checkLevel >= DCM_CHECK_CHECKSUM)
+        return DCMGenChecksum(CHUNK_CS_DATA_ADDR(chunkBase), CHUNK_CS_DATA_LEN(chunkBase));
+    else
+        return CHUNK_CS_DEFAULT_VAL;
+}
 
 /*
  * 功能：判断容器是否为空
@@ -122,31 +219,84 @@ static inline char DCMContainerIsEmpty(DCMContainer *container)
             && container->prev == CONTAINER_NODE(container);
 }
 
+/*
+ * 功能：查找地址所在的区域，区域末尾的哨兵不属于区域。
+ * 返回值：地址所在的区域，地址不属于任何区域时返回NULL。
+ */
+static inline DCMRegion *DCMFindRegion(DynamicCtnMan *dcm, void *address)
+{
+    uint8_t *addr = (uint8_t *)address;
+    unsigned int i;
+
+    for (i = 0; i < dcm->regionCount; i++) {
+        if (addr >= dcm->regions[i].base
+                && addr < dcm->regions[i].base + dcm->regions[i].size)
+            return &dcm->regions[i];
+    }
+    return NULL;
+}
+
 /*
  * 功能：判断地址是否有效
  * 返回值：地址有效返回1，否则返回0。
  */
 static inline char DCMAddressIsValid(DynamicCtnMan *dcm, void *address)
 {
-    uint8_t *addr = (uint8_t *)address;
+    return DCMFindRegion(dcm, address) != NULL;
+}
+
+/*
+ * 功能：判断块尺寸是否有效：不小于最小块尺寸、按MEM_MAN_ALIGN_SIZE对齐且不超出所在的区域。
+ * 返回值：块尺寸有效返回1，否则返回0。
+ */
+static inline char DCMChunkSizeIsValid(DynamicCtnMan *dcm, uint8_t *chunkBase)
+{
+    DCMRegion *region = DCMFindRegion(dcm, chunkBase);
+    size_t chunkSize;
+
+    if (!region)
+        return 0;
+    chunkSize = BASE_TO_LMARKER(chunkBase)->chunkSize;
+    return chunkSize >= CHUNK_MIN_SIZE
+            && chunkSize % MEM_MAN_ALIGN_SIZE == 0
+            && chunkSize <= (size_t)(region->base + region->size - chunkBase);
+}
+
+/*
+ * 功能：判断已分配块是否有效：左边界标记为已使用，且右相邻块（或区域末尾的哨兵）记录左相邻块被使用。
+ * 返回值：块有效返回1，否则返回0。
+ */
+static inline char DCMUsedChunkIsValid(DynamicCtnMan *dcm, uint8_t *chunkBase)
+{
+    if ((size_t)chunkBase % MEM_MAN_ALIGN_SIZE
+            || !DCMChunkSizeIsValid(dcm, chunkBase)
+            || !BASE_TO_LMARKER(chunkBase)->used)
+        return 0;
+    return CHUNK_RNB_LMARKER(chunkBase)->prevUsed;
+}
 
-    return (addr >= dcm->memBase
-            && addr < dcm->memBase + dcm->memSize);
+/*
+ * 功能：设置右相邻块（或区域末尾的哨兵）左边界标记中的prevUsed标志
+ * 返回值：无
+ */
+static inline void DCMChunkSetRNbPrevUsed(DynamicCtnMan *dcm, uint8_t *chunkBase, uint32_t used)
+{
+    (void)dcm;
+    CHUNK_RNB_LMARKER(chunkBase)->prevUsed = used;
 }
 
 /*
- * 功能：判断块是否有效
+ * 功能：判断空闲块是否有效
  * 返回值：块有效返回1，否则返回0。
  */
 static inline char DCMChunkIsValid(DynamicCtnMan *dcm, uint8_t *chunkBase)
 {
     DCMBoundaryMarker *leftMarker, *rightMarker;
 
-    if (DCMAddressIsValid(dcm, chunkBase)) {
+    if (DCMChunkSizeIsValid(dcm, chunkBase)) {
         leftMarker = BASE_TO_LMARKER(chunkBase);
         rightMarker = BASE_TO_RMARKER(chunkBase);
-        if (chunkBase + leftMarker->chunkSize <= dcm->memBase + dcm->memSize
-                && leftMarker->chunkSize == rightMarker->chunkSize
+        if (leftMarker->chunkSize == rightMarker->chunkSize
                 && leftMarker->used == rightMarker->used) {
             return 1;
         } else {
@@ -157,55 +307,128 @@ static inline char DCMChunkIsValid(DynamicCtnMan *dcm, uint8_t *chunkBase)
     }
 }
 
+#ifdef DCM_OOL_META
+/*
+ * 功能：判断元数据表项地址是否有效：位于堆区中且按指针尺寸对齐。
+ * 返回值：地址有效返回1，否则返回0。
+ */
+static inline char DCMMetaAddressIsValid(DynamicCtnMan *dcm, DCMMeta *meta)
+{
+    return (size_t)meta % sizeof (void *) == 0 && DCMAddressIsValid(dcm, meta);
+}
+
+/*
+ * 功能：DCM_OOL_META模式下判断块是否为有效的空闲块：左边界标记为空闲，且元数据表项记录的块基址和尺寸与之一致，
+ *      不读取块末尾的右边界标记。没有表项的孤立块检查左右边界标记。DCM_CHECK_CHECKSUM及以上级别还校验数据区。
+ * 返回值：块是有效的空闲块返回1，否则返回0。
+ */
+static inline char DCMMetaChunkIsFree(DynamicCtnMan *dcm, uint8_t *chunkBase)
+{
+    DCMBoundaryMarker *leftMarker;
+    DCMMeta *meta;
+
+    if (!DCMChunkSizeIsValid(dcm, chunkBase))
+        return 0;
+    leftMarker = BASE_TO_LMARKER(chunkBase);
+    if (leftMarker->used)
+        return 0;
+    meta = CHUNK_NODE(chunkBase);
+    if (!meta)
+        return DCMChunkIsValid(dcm, chunkBase);
+    if (!DCMMetaAddressIsValid(dcm, meta)
+            || meta->base != chunkBase
+            || meta->chunkSize != leftMarker->chunkSize)
+        return 0;
+    if (dcm->checkLevel >= DCM_CHECK_CHECKSUM
+            && leftMarker->checksum != DCMChunkChecksum(dcm, chunkBase)) {
+        printf("chunk [%p(H)] is invalid\n", chunkBase);
+        return 0;
+    }
+    return 1;
+}
+#endif
+
+/*
+ * 功能：按照当前检查级别判断块是否为有效的空闲块。DCM_CHECK_NONE级别下只读取左边界标记的使用标志，
+ *      因此不会检测到块损坏，也不会进入损坏块的恢复流程。
+ * 返回值：块是有效的空闲块返回1，否则返回0。
+ */
 static inline char DCMChunkIsFree(DynamicCtnMan *dcm, uint8_t *chunkBase)
 {
-    if (DCMChunkIsValid(dcm, chunkBase)) {
-        DCMBoundaryMarker *leftMarker;
-        DCMBoundaryMarker *rightMarker;
-        uint16_t checksum;
+    DCMBoundaryMarker *leftMarker;
+    DCMBoundaryMarker *rightMarker;
+    uint16_t checksum;
+
+    if (dcm->checkLevel == DCM_CHECK_NONE)
+        return BASE_TO_LMARKER(chunkBase)->used == 0;
 
+#ifdef DCM_OOL_META
+    return DCMMetaChunkIsFree(dcm, chunkBase);
+#endif
+    if (DCMChunkIsValid(dcm, chunkBase)) {
         leftMarker = BASE_TO_LMARKER(chunkBase);
         rightMarker = BASE_TO_RMARKER(chunkBase);
-#ifdef DCM_CHECKSUM
-
-        checksum = DCMGenChecksum(CHUNK_CS_DATA_ADDR(chunkBase), CHUNK_CS_DATA_LEN(chunkBase));
+        if (leftMarker->used)
+            return 0;
+        checksum = DCMChunkChecksum(dcm, chunkBase);
         if (leftMarker->checksum == rightMarker->checksum
                 && leftMarker->checksum == checksum) {
-            return leftMarker->used == 0;
+            return 1;
         } else {
-            if (leftMarker->used == 0) {
+            if (dcm->checkLevel >= DCM_CHECK_CHECKSUM) {
                 printf("chunk [%p(H)] is invalid\n", chunkBase);
             }
             return 0;
         }
-#else
-        (void)checksum;
-        if (leftMarker->checksum == rightMarker->checksum
-                && leftMarker->checksum == CHUNK_CS_DEFAULT_VAL) {
-            return leftMarker->used == 0;
-        } else {
-            return 0;
-        }
-#endif
     } else {
         return 0;
     }
 }
 
+/*
+ * 功能：判断容器链表中的节点是否代表有效的空闲块。DCM_OOL_META模式下只检查元数据表项，不访问块本身。
+ * 返回值：节点有效返回1，否则返回0。
+ */
+static inline char DCMNodeIsFree(DynamicCtnMan *dcm, void *chunkNode)
+{
+#ifdef DCM_OOL_META
+    if (dcm->checkLevel == DCM_CHECK_NONE)
+        return 1;
+    return DCMMetaAddressIsValid(dcm, chunkNode)
+            && DCMAddressIsValid(dcm, NODE_TO_CHUNK(chunkNode));
+#else
+    return DCMChunkIsFree(dcm, NODE_TO_CHUNK(chunkNode));
+#endif
+}
+
 /*
  * 功能：取value以2为底的对数
  * 返回值：value以2为底的对数
  */
-static size_t DCMLog2(size_t value)
+static inline size_t DCMLog2(size_t value)
 {
-    size_t i;
+    return value ? CplFls64(value) : 0;
+}
 
-    for (i = 0; ; i++) {
-        value /= 2;
-        if (value == 0)
-            return i;
+#ifdef DCM_TLSF
+/*
+ * 功能：计算窗口尺寸对应的一级和二级容器索引
+ * 返回值：无
+ */
+static inline void DCMTlsfMapping(size_t holeSize, size_t *pFl, size_t *pSl)
+{
+    size_t log2;
+
+    if (holeSize < DCM_SMALL_SIZE) {
+        *pFl = 0;
+        *pSl = holeSize / (DCM_SMALL_SIZE / DCM_SL_COUNT);
+    } else {
+        log2 = DCMLog2(holeSize);
+        *pFl = log2 - DCM_FL_SHIFT + 1;
+        *pSl = (holeSize >> (log2 - DCM_SL_LOG2)) ^ DCM_SL_COUNT;
     }
 }
+#endif
 
 /*
  * 功能：根据块尺寸选择合适的容器
@@ -215,11 +438,47 @@ static DCMContainer * DCMSelectChunkContainer(DynamicCtnMan *dcm, size_t chunkSi
 {
     size_t pos;
 
+#ifdef DCM_TLSF
+    size_t fl, sl;
+
+    DCMTlsfMapping(CHUNK_SIZE_TO_HOLE_SIZE(chunkSize), &fl, &sl);
+    pos = fl * DCM_SL_COUNT + sl;
+#else
     /*根据块的窗口尺寸选择容器，对窗口尺寸取2为底的对数，此对数值作为管理器中容器的索引。*/
     pos = DCMLog2(CHUNK_SIZE_TO_HOLE_SIZE(chunkSize));
+#endif
     return &dcm->containers[pos];
 }
 
+/*
+ * 功能：容器中的块发生变化后，根据容器是否为空更新非空容器位图。
+ * 返回值：无
+ */
+static inline void DCMContainerUpdateMap(DynamicCtnMan *dcm, DCMContainer *container)
+{
+#ifdef DCM_TLSF
+    size_t pos = container - dcm->containers;
+    size_t fl = pos / DCM_SL_COUNT, sl = pos % DCM_SL_COUNT;
+
+    if (DCMContainerIsEmpty(container)) {
+        dcm->slBitmap[fl] &= ~(1U << sl);
+        if (!dcm->slBitmap[fl])
+            dcm->flBitmap &= ~((uint64_t)1 << fl);
+    } else {
+        dcm->slBitmap[fl] |= 1U << sl;
+        dcm->flBitmap |= (uint64_t)1 << fl;
+    }
+#else
+    uint64_t bit = (uint64_t)1 << (container - dcm->containers);
+
+    if (DCMContainerIsEmpty(container))
+        dcm->binBitmap &= ~bit;
+    else
+        dcm->binBitmap |= bit;
+#endif
+}
+
+#ifndef DCM_OOL_META
 /*
  * 功能：判断两个块是否在同一个容器中。
  * 返回值：如果两个块是否在同一个容器中返回1，否则返回0。
@@ -239,6 +498,22 @@ static char DCMChunksIsInOneContainer(DynamicCtnMan *dcm, uint8_t *lChunk, uint8
     rChunkSize = BASE_TO_LMARKER(rChunk)->chunkSize;
     return DCMSelectChunkContainer(dcm, lChunkSize) == DCMSelectChunkContainer(dcm, rChunkSize);
 }
+#endif
+
+/*
+ * 功能：判断两个节点是否在同一个容器中，DCM_OOL_META模式下根据元数据表项判断。
+ * 返回值：如果两个节点在同一个容器中返回1，否则返回0。
+ **/
+static inline char DCMNodesIsInOneContainer(DynamicCtnMan *dcm, DCMContainer *container, void *startNode, void *iterNode)
+{
+#ifdef DCM_OOL_META
+    (void)startNode;
+    return DCMSelectChunkContainer(dcm, ((DCMMeta *)iterNode)->chunkSize) == container;
+#else
+    (void)container;
+    return DCMChunksIsInOneContainer(dcm, NODE_TO_CHUNK(startNode), NODE_TO_CHUNK(iterNode));
+#endif
+}
 
 /*
  * 功能：根据块的前向链接指针寻找块的下一个有效节点，用于绕过坏块
@@ -255,7 +530,7 @@ static void *DCMSearchNextValidNode(DynamicCtnMan *dcm, DCMContainer *container,
     if (CONTAINER_NODE(container) == startNode) {
         iterNode = container->prev;
     } else {
-        iterNode = CHUNK_GET_PREV_NODE(NODE_TO_CHUNK(startNode));
+        iterNode = NODE_GET_PREV(startNode);
     }
     for (; iterNode != startNode; ) {
         if (CONTAINER_NODE(container) == iterNode) {
@@ -263,10 +538,10 @@ static void *DCMSearchNextValidNode(DynamicCtnMan *dcm, DCMContainer *container,
             iterNode = container->prev;
         }  else {
             /*判断迭代节点和起始节点是否在同一容器中，如果内存内容被非法修改（极端情况），也能退出循环。*/
-            if (DCMChunkIsFree(dcm, NODE_TO_CHUNK(iterNode))
-                    && DCMChunksIsInOneContainer(dcm, NODE_TO_CHUNK(startNode), NODE_TO_CHUNK(iterNode))) {
+            if (DCMNodeIsFree(dcm, iterNode)
+                    && DCMNodesIsInOneContainer(dcm, container, startNode, iterNode)) {
                 validNode = iterNode;
-                iterNode = CHUNK_GET_PREV_NODE(NODE_TO_CHUNK(iterNode));
+                iterNode = NODE_GET_PREV(iterNode);
             } else {
                 return validNode;
             }
@@ -290,7 +565,7 @@ static void *DCMSearchPrevValidNode(DynamicCtnMan *dcm, DCMContainer *container,
     if (CONTAINER_NODE(container) == startNode) {
         iterNode = container->next;
     } else {
-        iterNode = CHUNK_GET_NEXT_NODE(NODE_TO_CHUNK(startNode));
+        iterNode = NODE_GET_NEXT(startNode);
     }
     for (; iterNode != startNode; ) {
         if (CONTAINER_NODE(container) == iterNode) {
@@ -298,10 +573,10 @@ static void *DCMSearchPrevValidNode(DynamicCtnMan *dcm, DCMContainer *container,
             iterNode = container->next;
         }  else {
             /*判断迭代节点和起始节点是否在同一容器中，如果内存内容被非法修改（极端情况），也能退出循环。*/
-            if (DCMChunkIsFree(dcm, NODE_TO_CHUNK(iterNode))
-                    && DCMChunksIsInOneContainer(dcm, NODE_TO_CHUNK(startNode), NODE_TO_CHUNK(iterNode))) {
+            if (DCMNodeIsFree(dcm, iterNode)
+                    && DCMNodesIsInOneContainer(dcm, container, startNode, iterNode)) {
                 validNode = iterNode;
-                iterNode = CHUNK_GET_NEXT_NODE(NODE_TO_CHUNK(iterNode));
+                iterNode = NODE_GET_NEXT(iterNode);
             } else {
                 return validNode;
             }
@@ -317,52 +592,262 @@ static void *DCMSearchPrevValidNode(DynamicCtnMan *dcm, DCMContainer *container,
  * 功能：把块节点添加到容器的首部
  * 返回值：
  **/
-static inline void DCMContainerAddNode(DCMContainer *container, void *chunkNode, uint8_t *nextChunkNode, char isEmpty)
+static inline void DCMContainerAddNode(DCMContainer *container, void *chunkNode, void *nextChunkNode, char isEmpty)
 {
-    uint8_t *chunkBase;
-
-    chunkBase = NODE_TO_CHUNK(chunkNode);
     /*把块添加到容器中的首部。*/
     if (isEmpty == CONTAINER_IS_EMPTY
             || chunkNode == nextChunkNode) {
         container->next = chunkNode;
         container->prev = chunkNode;
-        CHUNK_SET_PREV_NODE(chunkBase, CONTAINER_NODE(container));
-        CHUNK_SET_NEXT_NODE(chunkBase, CONTAINER_NODE(container));
+        NODE_SET_PREV(chunkNode, CONTAINER_NODE(container));
+        NODE_SET_NEXT(chunkNode, CONTAINER_NODE(container));
     } else {
         container->next = chunkNode;
-        CHUNK_SET_PREV_NODE(NODE_TO_CHUNK(nextChunkNode), chunkNode);
-        CHUNK_SET_PREV_NODE(chunkBase, CONTAINER_NODE(container));
-        CHUNK_SET_NEXT_NODE(chunkBase, nextChunkNode);
+        NODE_SET_PREV(nextChunkNode, chunkNode);
+        NODE_SET_PREV(chunkNode, CONTAINER_NODE(container));
+        NODE_SET_NEXT(chunkNode, nextChunkNode);
     }
 }
 
 /*
- * 功能：向容器中添加块
+ * 功能：把块节点添加到容器链表的首部
  * 返回值：无
  */
-static void DCMContainerAddChunk(DynamicCtnMan *dcm, DCMContainer *container, uint8_t *chunkBase)
+static void DCMContainerLinkNode(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode)
 {
     /*把块添加到容器中的首部。*/
     if (DCMContainerIsEmpty(container)) {
-        DCMContainerAddNode(container, CHUNK_NODE(chunkBase), NULL, CONTAINER_IS_EMPTY);
+        DCMContainerAddNode(container, chunkNode, NULL, CONTAINER_IS_EMPTY);
     } else {
         void *nextNode;
 
         nextNode = container->next;
-        if (!DCMChunkIsFree(dcm, NODE_TO_CHUNK(nextNode))) {    //删除无效节点，使用块前向链接指针寻找有效节点并处理。
+        if (!DCMNodeIsFree(dcm, nextNode)) {    //删除无效节点，使用块前向链接指针寻找有效节点并处理。
             PrDbg("first node [%p(H)] is invalide\n", nextNode);
             nextNode = DCMSearchNextValidNode(dcm, container, CONTAINER_NODE(container));
             if (nextNode == CONTAINER_NODE(container)) {
                 container->chunkCnt++;
-                DCMContainerAddNode(container, CHUNK_NODE(chunkBase), NULL, CONTAINER_IS_EMPTY);
+                DCMContainerAddNode(container, chunkNode, NULL, CONTAINER_IS_EMPTY);
+                DCMContainerUpdateMap(dcm, container);
                 return;
             }
         }
-        DCMContainerAddNode(container, CHUNK_NODE(chunkBase), nextNode, CONTAINER_IS_NO_EMPTY);
+        DCMContainerAddNode(container, chunkNode, nextNode, CONTAINER_IS_NO_EMPTY);
+    }
+    container->chunkCnt++;
+    DCMContainerUpdateMap(dcm, container);
+}
+
+#ifdef DCM_TREE
+/*
+ * 功能：判断容器是否为树容器
+ * 返回值：是树容器返回1，否则返回0。
+ */
+static inline char DCMContainerIsTree(DynamicCtnMan *dcm, DCMContainer *container)
+{
+    return container - dcm->containers >= DCM_TREE_MIN_LOG2;
+}
+
+/*
+ * 功能：按照当前检查级别判断树节点是否代表容器中的有效空闲块，用于在遍历字典树时发现坏块。
+ * 返回值：节点有效返回1，否则返回0。
+ */
+static inline char DCMTreeNodeIsValid(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode)
+{
+    if (dcm->checkLevel == DCM_CHECK_NONE)
+        return 1;
+    return DCMNodeIsFree(dcm, chunkNode)
+            && DCMSelectChunkContainer(dcm, HOLE_SIZE_TO_CHUNK_SIZE(NODE_HOLE_SIZE(chunkNode))) == container;
+}
+
+/*
+ * 功能：把块节点插入容器链表中prevNode节点之后
+ * 返回值：无
+ */
+static inline void DCMContainerLinkNodeAfter(DCMContainer *container, void *chunkNode, void *prevNode)
+{
+    void *nextNode;
+
+    nextNode = NODE_GET_NEXT(prevNode);
+    NODE_SET_PREV(chunkNode, prevNode);
+    NODE_SET_NEXT(chunkNode, nextNode);
+    NODE_SET_NEXT(prevNode, chunkNode);
+    if (nextNode == CONTAINER_NODE(container))
+        container->prev = chunkNode;
+    else
+        NODE_SET_PREV(nextNode, chunkNode);
+}
+
+/*
+ * 功能：把块节点插入树容器。从根节点开始按窗口尺寸的比特位逐层下降，在空的子节点处插入并添加到链表首部；
+ *      遇到同尺寸的块时作为重复块插入链表中该块之后。遇到坏块时不修改容器。
+ * 返回值：成功时返回0，遇到坏块时返回-EFAULT。
+ */
+static int DCMTreeInsert(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode)
+{
+    DCMTreeNode *tnode;
+    size_t holeSize;
+    uint64_t bits;
+    void *iterNode, **link, *nextNode;
+
+    tnode = NODE_TO_TNODE(chunkNode);
+    tnode->child[0] = tnode->child[1] = NULL;
+    if (!container->root) {
+        tnode->parent = CONTAINER_NODE(container);
+        container->root = chunkNode;
+        DCMContainerLinkNode(dcm, container, chunkNode);
+        return 0;
+    }
+
+    /*容器中块的窗口尺寸最高位都相同，从次高位开始选择子节点。*/
+    holeSize = NODE_HOLE_SIZE(chunkNode);
+    bits = (uint64_t)holeSize << (64 - (container - dcm->containers));
+    for (iterNode = container->root; ; bits <<= 1) {
+        if (!DCMTreeNodeIsValid(dcm, container, iterNode))
+            return -EFAULT;
+        if (NODE_HOLE_SIZE(iterNode) == holeSize)
+            break;
+        link = &NODE_TO_TNODE(iterNode)->child[bits >> 63];
+        if (!*link) {
+            *link = chunkNode;
+            tnode->parent = iterNode;
+            DCMContainerLinkNode(dcm, container, chunkNode);
+            return 0;
+        }
+        iterNode = *link;
     }
+
+    nextNode = NODE_GET_NEXT(iterNode);
+    if (nextNode != CONTAINER_NODE(container)
+            && !DCMTreeNodeIsValid(dcm, container, nextNode))
+        return -EFAULT;
+    tnode->parent = NULL;
+    DCMContainerLinkNodeAfter(container, chunkNode, iterNode);
     container->chunkCnt++;
+    return 0;
+}
+
+/*
+ * 功能：字典树中出现坏块时，沿容器链表收集有效的块（绕过坏块），清空容器后重新插入。
+ * 返回值：无
+ */
+static void DCMTreeRebuild(DynamicCtnMan *dcm, DCMContainer *container)
+{
+    void *iterNode, *lastNode, *chain = NULL, *nextNode;
+
+    PrDbg("rebuild tree of container [%p(H)]\n", container);
+    /*收集的节点通过后向节点指针串成单向链表，绕过坏块时只使用前向节点指针。*/
+    lastNode = CONTAINER_NODE(container);
+    iterNode = container->next;
+    for ( ;iterNode != CONTAINER_NODE(container); ) {
+        if (!DCMTreeNodeIsValid(dcm, container, iterNode)) {
+            iterNode = DCMSearchNextValidNode(dcm, container, lastNode);
+            if (iterNode == CONTAINER_NODE(container)
+                    || iterNode == lastNode)
+                break;
+        }
+        lastNode = iterNode;
+        nextNode = NODE_GET_NEXT(iterNode);
+        NODE_SET_NEXT(iterNode, chain);
+        chain = iterNode;
+        iterNode = nextNode;
+    }
+
+    container->prev = container->next = CONTAINER_NODE(container);
+    container->root = NULL;
+    container->chunkCnt = 0;
+    for (; chain; chain = nextNode) {
+        nextNode = NODE_GET_NEXT(chain);
+        /*树中只有刚校验过的块，插入不会失败。*/
+        DCMTreeInsert(dcm, container, chain);
+    }
+    DCMContainerUpdateMap(dcm, container);
+}
+#endif
+
+/*
+ * 功能：向容器中添加块节点
+ * 返回值：无
+ */
+static void DCMContainerAddChunk(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode)
+{
+#ifdef DCM_TREE
+    if (DCMContainerIsTree(dcm, container)) {
+        if (DCMTreeInsert(dcm, container, chunkNode) != 0) {
+            DCMTreeRebuild(dcm, container);
+            DCMTreeInsert(dcm, container, chunkNode);
+        }
+        return;
+    }
+#endif
+    DCMContainerLinkNode(dcm, container, chunkNode);
+}
+
+#ifdef DCM_OOL_META
+/*
+ * 功能：把一页内存划分为元数据表项并加入空闲表项链表
+ * 返回值：无
+ */
+static void DCMMetaAddPage(DynamicCtnMan *dcm, void *page, size_t size)
+{
+    DCMMeta *meta = (DCMMeta *)page;
+    size_t n;
+
+    for (n = size / sizeof (DCMMeta); n > 0; n--, meta++) {
+        meta->base = NULL;
+        meta->next = dcm->metaFree;
+        dcm->metaFree = meta;
+    }
+}
+
+static void *DCMAllocFit(DynamicCtnMan *dcm, size_t size);
+
+/*
+ * 功能：为chunkSize大小的空闲块获取一个元数据表项。没有空闲表项时从堆区分配一个元数据页，
+ *      堆区中没有足够大的块时从该块尾部切分出一页，*pChunkSize相应减小。
+ * 返回值：元数据表项，无法获取时返回NULL。
+ */
+static DCMMeta *DCMMetaGet(DynamicCtnMan *dcm, uint8_t *chunkBase, size_t *pChunkSize)
+{
+    DCMBoundaryMarker *pageMarker;
+    DCMMeta *meta;
+    uint8_t *page;
+    size_t pageChunkSize = HOLE_SIZE_TO_CHUNK_SIZE(DCM_META_PAGE_SIZE);
+
+    if (!dcm->metaFree) {
+        /*分配会先从容器中取出一个块再放回剩余部分，放回时复用取出块的表项。*/
+        page = DCMAllocFit(dcm, DCM_META_PAGE_SIZE);
+        if (page) {
+            DCMMetaAddPage(dcm, page, DCM_META_PAGE_SIZE);
+        } else if (*pChunkSize >= pageChunkSize + CHUNK_MIN_SIZE) {
+            /*元数据页作为已分配块位于空闲块之后，添加空闲块时会清除其prevUsed标志。*/
+            *pChunkSize -= pageChunkSize;
+            pageMarker = BASE_TO_LMARKER(chunkBase + *pChunkSize);
+            pageMarker->used = 1;
+            pageMarker->zeroed = 0;
+            pageMarker->chunkSize = pageChunkSize;
+            DCMChunkSetRNbPrevUsed(dcm, LMARKER_TO_BASE(pageMarker), 1);
+            DCMMetaAddPage(dcm, BASE_TO_LPOINTER(LMARKER_TO_BASE(pageMarker)), DCM_META_PAGE_SIZE);
+        } else {
+            return NULL;
+        }
+    }
+    meta = dcm->metaFree;
+    dcm->metaFree = meta->next;
+    return meta;
+}
+
+/*
+ * 功能：归还元数据表项
+ * 返回值：无
+ */
+static inline void DCMMetaPut(DynamicCtnMan *dcm, DCMMeta *meta)
+{
+    meta->base = NULL;
+    meta->next = dcm->metaFree;
+    dcm->metaFree = meta;
 }
+#endif
 
 /*
  * 功能：向管理器中添加块
@@ -372,23 +857,54 @@ static void DCMAddChunk(DynamicCtnMan *dcm, uint8_t *chunkBase, size_t chunkSize
 {
     DCMContainer *container;
     DCMBoundaryMarker *leftMarker, *rightMarker;
+    char isTop;
+#ifdef DCM_OOL_META
+    DCMMeta *meta = NULL;
+#endif
+
+    /*结束于顶块区域末尾的块成为顶块，不放入容器。*/
+    isTop = chunkBase + chunkSize == dcm->topEnd;
+#ifdef DCM_OOL_META
+    if (!isTop)
+        meta = DCMMetaGet(dcm, chunkBase, &chunkSize);
+#endif
 
-    /*推算出块的左右边界标记，并写入块的信息。*/
+    /*推算出块的左右边界标记，并写入块的信息。空闲块总会和相邻的空闲块合并，
+        因此左相邻块一定被使用（或不存在）。*/
     leftMarker = BASE_TO_LMARKER(chunkBase);
     leftMarker->used = 0;
+    leftMarker->prevUsed = 1;
+    leftMarker->zeroed = 0;
     leftMarker->chunkSize = chunkSize;
     rightMarker = BASE_TO_RMARKER(chunkBase);
     *rightMarker = *leftMarker;
+    DCMChunkSetRNbPrevUsed(dcm, chunkBase, 0);
+#ifdef DCM_OOL_META
+    CHUNK_SET_NODE(chunkBase, meta);
+#endif
+    if (isTop) {
+        dcm->top = chunkBase;
+        leftMarker->checksum = DCMChunkChecksum(dcm, chunkBase);
+        rightMarker->checksum = leftMarker->checksum;
+        return;
+    }
+#ifdef DCM_OOL_META
+    if (meta) {
+        meta->base = chunkBase;
+        meta->chunkSize = chunkSize;
+    } else {
+        /*元数据表项耗尽时块成为不在容器中的孤立块，相邻块释放时仍会与其合并。*/
+        PrDbg("chunk [%p(H)] is orphaned\n", chunkBase);
+        leftMarker->checksum = DCMChunkChecksum(dcm, chunkBase);
+        rightMarker->checksum = leftMarker->checksum;
+        return;
+    }
+#endif
     /*根据块的窗口尺寸选择合适的容器并将其添加到容器首部。*/
     container = DCMSelectChunkContainer(dcm, chunkSize);
-    DCMContainerAddChunk(dcm, container, chunkBase);
-#ifdef DCM_CHECKSUM
-    leftMarker->checksum = DCMGenChecksum(CHUNK_CS_DATA_ADDR(chunkBase), CHUNK_CS_DATA_LEN(chunkBase));
+    DCMContainerAddChunk(dcm, container, CHUNK_NODE(chunkBase));
+    leftMarker->checksum = DCMChunkChecksum(dcm, chunkBase);
     rightMarker->checksum = leftMarker->checksum;
-#else
-    leftMarker->checksum = CHUNK_CS_DEFAULT_VAL;
-    rightMarker->checksum = CHUNK_CS_DEFAULT_VAL;
-#endif
 }
 
 /*
@@ -410,274 +926,1550 @@ static void DCMDelNode(DCMContainer *container, void *prevNode, void *nextNode)
             container->next = container->prev = CONTAINER_NODE(container);
         } else {
             container->next = nextNode;
-            CHUNK_SET_PREV_NODE(NODE_TO_CHUNK(nextNode), CONTAINER_NODE(container));
+            NODE_SET_PREV(nextNode, CONTAINER_NODE(container));
         }
     } else {
         if (nextNode == CONTAINER_NODE(container)) {
-            CHUNK_SET_NEXT_NODE(NODE_TO_CHUNK(prevNode), CONTAINER_NODE(container));
+            NODE_SET_NEXT(prevNode, CONTAINER_NODE(container));
             container->prev = prevNode;
         } else {
-            CHUNK_SET_NEXT_NODE(NODE_TO_CHUNK(prevNode), nextNode);
-            CHUNK_SET_PREV_NODE(NODE_TO_CHUNK(nextNode), prevNode);
+            NODE_SET_NEXT(prevNode, nextNode);
+            NODE_SET_PREV(nextNode, prevNode);
         }
     }
 }
 
 /*
- * 功能：从容器中删除块
+ * 功能：从容器链表中删除块节点
  * 返回值：无
  */
-static void DCMContainerDelChunk(DynamicCtnMan *dcm, DCMContainer *container, uint8_t *chunkBase)
+static void DCMContainerUnlinkNode(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode)
 {
     void *prevNode, *nextNode;
 
-    prevNode = CHUNK_GET_PREV_NODE(chunkBase);
-    nextNode = CHUNK_GET_NEXT_NODE(chunkBase);
+    prevNode = NODE_GET_PREV(chunkNode);
+    nextNode = NODE_GET_NEXT(chunkNode);
 
     /*使节点代表有效块或者容器*/
     if (prevNode == CONTAINER_NODE(container)) {        /*前向节点是容器*/
         if (nextNode != CONTAINER_NODE(container)) {    /*后向节点是容器*/
-            uint8_t *nextChunkBase;
-
-            nextChunkBase = NODE_TO_CHUNK(nextNode);
-            if (!DCMChunkIsFree(dcm, nextChunkBase)) {
-                PrDbg("first node [%p(H)] is invalide\n", nextChunkBase);
-                nextNode = DCMSearchNextValidNode(dcm, container, CHUNK_NODE(chunkBase));
-                if (CHUNK_NODE(chunkBase) == nextNode
+            if (!DCMNodeIsFree(dcm, nextNode)) {
+                PrDbg("first node [%p(H)] is invalide\n", nextNode);
+                nextNode = DCMSearchNextValidNode(dcm, container, chunkNode);
+                if (chunkNode == nextNode
                         || CONTAINER_NODE(container) == nextNode) {
                     container->prev = container->next = CONTAINER_NODE(container);
-                    return;
+                    goto out;
                 }
             }
         }
     } else {                                            /*前向节点是块*/
         if (nextNode == CONTAINER_NODE(container)) {    /*后向节点是容器*/
-            uint8_t *prevChunkBase;
-
-            prevChunkBase = NODE_TO_CHUNK(prevNode);
-            if (!DCMChunkIsFree(dcm, prevChunkBase)) {
-                PrDbg("tail node [%p(H)] is invalide\n", prevChunkBase);
-                prevNode = DCMSearchPrevValidNode(dcm, container, CHUNK_NODE(chunkBase));
-                if (prevNode == CHUNK_NODE(chunkBase)
+            if (!DCMNodeIsFree(dcm, prevNode)) {
+                PrDbg("tail node [%p(H)] is invalide\n", prevNode);
+                prevNode = DCMSearchPrevValidNode(dcm, container, chunkNode);
+                if (prevNode == chunkNode
                         || CONTAINER_NODE(container) == prevNode) {
                     container->prev = container->next = CONTAINER_NODE(container);
-                    return;
+                    goto out;
                 }
             }
         } else {                                        /*后向节点是块*/
-            uint8_t *prevChunkBase, *nextChunkBase;
-
-            prevChunkBase = NODE_TO_CHUNK(prevNode);
-            if (!DCMChunkIsFree(dcm, prevChunkBase)) {
-                PrDbg("prev node [%p(H)] is invalide\n", prevChunkBase);
-                prevNode = DCMSearchPrevValidNode(dcm, container, CHUNK_NODE(chunkBase));
-                if (prevNode == CHUNK_NODE(chunkBase)) {
+            if (!DCMNodeIsFree(dcm, prevNode)) {
+                PrDbg("prev node [%p(H)] is invalide\n", prevNode);
+                prevNode = DCMSearchPrevValidNode(dcm, container, chunkNode);
+                if (prevNode == chunkNode) {
                     container->prev = container->next = CONTAINER_NODE(container);
-                    return;
+                    goto out;
                 }
             }
-            nextChunkBase = NODE_TO_CHUNK(nextNode);
-            if (!DCMChunkIsFree(dcm, nextChunkBase)) {
-                PrDbg("next node [%p(H)] is invalide\n", nextChunkBase);
-                nextNode = DCMSearchNextValidNode(dcm, container, CHUNK_NODE(chunkBase));
-                if (CHUNK_NODE(chunkBase) == nextNode) {
+            if (!DCMNodeIsFree(dcm, nextNode)) {
+                PrDbg("next node [%p(H)] is invalide\n", nextNode);
+                nextNode = DCMSearchNextValidNode(dcm, container, chunkNode);
+                if (chunkNode == nextNode) {
                     container->prev = container->next = CONTAINER_NODE(container);
-                    return;
+                    goto out;
                 }
             }
         }
     }
     DCMDelNode(container, prevNode, nextNode);
     container->chunkCnt--;
+out:
+    DCMContainerUpdateMap(dcm, container);
 }
+
+#ifdef DCM_TREE
 /*
- * 功能：分配容器中的块
- * 返回值：无
+ * 功能：从字典树中删除块节点，不修改容器链表。块有重复块时由紧随其后的重复块取代其位置，
+ *      否则由子树中任意一个叶子节点取代。修改前校验所有涉及的块，遇到坏块时不修改字典树。
+ * 返回值：成功时返回0，遇到坏块时返回-EFAULT。
  */
-static void DCMContainerChunkAlloc(DynamicCtnMan *dcm, DCMContainer *container,
-                             uint8_t *chunkBase, size_t allocSize)
+static int DCMTreeDelNode(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode)
 {
-    DCMBoundaryMarker *leftMarker, *rightMarker;
-    size_t remain;
+    DCMTreeNode *tnode, *parentNode = NULL;
+    void *parent, *repl = NULL, **replLink, **childLink, *nextNode;
+    int i;
+
+    tnode = NODE_TO_TNODE(chunkNode);
+    parent = tnode->parent;
+    if (!parent)                /*重复块不在树中。*/
+        return 0;
+    if (parent != CONTAINER_NODE(container)) {
+        if (!DCMTreeNodeIsValid(dcm, container, parent))
+            return -EFAULT;
+        parentNode = NODE_TO_TNODE(parent);
+        if (parentNode->child[0] != chunkNode && parentNode->child[1] != chunkNode)
+            return -EFAULT;
+    } else if (container->root != chunkNode) {
+        return -EFAULT;
+    }
+    for (i = 0; i < 2; i++) {
+        if (tnode->child[i] && !DCMTreeNodeIsValid(dcm, container, tnode->child[i]))
+            return -EFAULT;
+    }
+
+    nextNode = NODE_GET_NEXT(chunkNode);
+    if (nextNode != CONTAINER_NODE(container)) {
+        if (!DCMTreeNodeIsValid(dcm, container, nextNode))
+            return -EFAULT;
+        if (NODE_HOLE_SIZE(nextNode) == NODE_HOLE_SIZE(chunkNode))
+            repl = nextNode;
+    }
+    if (!repl) {
+        /*叶子节点与该块有相同的比特位前缀，可以取代该块。*/
+        replLink = tnode->child[1] ? &tnode->child[1] : &tnode->child[0];
+        for (repl = *replLink; repl; repl = *replLink) {
+            if (!DCMTreeNodeIsValid(dcm, container, repl))
+                return -EFAULT;
+            childLink = NODE_TO_TNODE(repl)->child[1] ? &NODE_TO_TNODE(repl)->child[1] : &NODE_TO_TNODE(repl)->child[0];
+            if (!*childLink)
+                break;
+            replLink = childLink;
+        }
+        if (repl)
+            *replLink = NULL;
+    }
+
+    if (parent == CONTAINER_NODE(container))
+        container->root = repl;
+    else
+        parentNode->child[parentNode->child[0] == chunkNode ? 0 : 1] = repl;
+    if (repl) {
+        NODE_TO_TNODE(repl)->parent = parent;
+        for (i = 0; i < 2; i++) {
+            NODE_TO_TNODE(repl)->child[i] = tnode->child[i];
+            if (tnode->child[i])
+                NODE_TO_TNODE(tnode->child[i])->parent = repl;
+        }
+    }
+    return 0;
+}
+#endif
+
+/*
+ * 功能：从容器中删除块节点
+ * 返回值：无
+ */
+static void DCMContainerDelNode(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode)
+{
+#ifdef DCM_TREE
+    int ret;
+
+    if (DCMContainerIsTree(dcm, container)) {
+        ret = DCMTreeDelNode(dcm, container, chunkNode);
+        DCMContainerUnlinkNode(dcm, container, chunkNode);
+        if (ret != 0)
+            DCMTreeRebuild(dcm, container);
+        return;
+    }
+#endif
+    DCMContainerUnlinkNode(dcm, container, chunkNode);
+}
+
+/*
+ * 功能：从容器中删除块
+ * 返回值：无
+ */
+static void DCMContainerDelChunk(DynamicCtnMan *dcm, DCMContainer *container, uint8_t *chunkBase)
+{
+#ifdef DCM_OOL_META
+    DCMMeta *meta = CHUNK_NODE(chunkBase);
+#endif
+
+    /*顶块不在容器中，取出后由剩余部分或合并后的块重新成为顶块。顶块不写入树节点，
+        但归还物理页时不清零树节点所在的区域，因此取出时同样需要清零。*/
+    if (chunkBase == dcm->top) {
+        dcm->top = NULL;
+        if (BASE_TO_LMARKER(chunkBase)->zeroed)
+            memset(CHUNK_CS_DATA_ADDR(chunkBase) - CHUNK_TREE_SIZE(chunkBase), 0, CHUNK_TREE_SIZE(chunkBase));
+        return;
+    }
+#ifdef DCM_OOL_META
+    /*孤立块不在容器中。*/
+    if (!meta)
+        return;
+    DCMContainerDelNode(dcm, container, meta);
+    DCMMetaPut(dcm, meta);
+#else
+    DCMContainerDelNode(dcm, container, CHUNK_NODE(chunkBase));
+#ifdef DCM_TREE
+    /*树节点不属于清零状态覆盖的内容，块被取出时清零，DCMCalloc才能只清除节点指针。*/
+    if (BASE_TO_LMARKER(chunkBase)->zeroed && DCMContainerIsTree(dcm, container))
+        memset(NODE_TO_TNODE(CHUNK_NODE(chunkBase)), 0, sizeof (DCMTreeNode));
+#endif
+#endif
+}
+
+#ifdef DCM_OOL_META
+/*
+ * 功能：分配前检查块时发现块损坏，直接根据元数据把节点从容器中删除并丢弃该块。
+ * 返回值：无
+ */
+static void DCMContainerDropNode(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode)
+{
+    PrDbg("chunk [%p(H)] is invalide\n", NODE_TO_CHUNK(chunkNode));
+    DCMContainerDelNode(dcm, container, chunkNode);
+    DCMMetaPut(dcm, chunkNode);
+}
+#endif
+
+/*
+ * 功能：分配容器中的块，分配顶块时container为NULL。
+ * 返回值：无
+ */
+static void DCMContainerChunkAlloc(DynamicCtnMan *dcm, DCMContainer *container,
+                             uint8_t *chunkBase, size_t allocSize)
+{
+    DCMBoundaryMarker *leftMarker;
+    size_t remain;
 
     /*如果块尺寸减去被分配的尺寸后大于等于CHUNK_MIN_SIZE，则把剩余尺寸添加到
-        管理器中，否则把整个块分配出去。*/
+        管理器中，否则把整个块分配出去。已分配块不需要右边界标记。*/
     leftMarker = BASE_TO_LMARKER(chunkBase);
-    remain = leftMarker->chunkSize - allocSize - BOUNDARY_MARKER_SIZE * 2;
+    remain = leftMarker->chunkSize - HOLE_SIZE_TO_CHUNK_SIZE(allocSize);
     DCMContainerDelChunk(dcm, container, chunkBase);
+    leftMarker->used = 1;
     if (remain >= CHUNK_MIN_SIZE) {
-        uint8_t *newChunkBase;
+        leftMarker->chunkSize = HOLE_SIZE_TO_CHUNK_SIZE(allocSize);
+        DCMAddChunk(dcm, chunkBase + leftMarker->chunkSize, remain);
+        /*剩余部分位于原块的数据区中，继承原块的清零状态。*/
+        BASE_TO_LMARKER(chunkBase + leftMarker->chunkSize)->zeroed = leftMarker->zeroed;
+    } else {
+        DCMChunkSetRNbPrevUsed(dcm, chunkBase, 1);
+    }
+}
+
+/*
+ * 功能：从顶块头部切分出allocSize大小的窗口，不查找和修改容器，剩余部分仍作为顶块。
+ * 返回值：成功时返回可用的地址指针，没有顶块或顶块不足时返回NULL。
+ */
+static void *DCMTopAlloc(DynamicCtnMan *dcm, size_t allocSize)
+{
+    uint8_t *chunkBase = dcm->top;
+
+    if (!chunkBase || CHUNK_HOLE_SIZE(chunkBase) < allocSize)
+        return NULL;
+    if (!DCMChunkIsFree(dcm, chunkBase)) {
+        PrDbg("top chunk [%p(H)] is invalide\n", chunkBase);
+        dcm->top = NULL;
+        return NULL;
+    }
+    DCMContainerChunkAlloc(dcm, NULL, chunkBase, allocSize);
+    return BASE_TO_LPOINTER(chunkBase);
+}
+
+/*
+ * 功能：把顶块所在的区域切换为末尾为topEnd的区域，原来的顶块放入容器。
+ * 返回值：无
+ */
+static void DCMSetTopEnd(DynamicCtnMan *dcm, uint8_t *topEnd)
+{
+    uint8_t *top = dcm->top;
+    char zeroed;
+
+    dcm->top = NULL;
+    dcm->topEnd = topEnd;
+    if (top) {
+        zeroed = BASE_TO_LMARKER(top)->zeroed;
+        DCMAddChunk(dcm, top, BASE_TO_LMARKER(top)->chunkSize);
+        BASE_TO_LMARKER(top)->zeroed = zeroed;
+    }
+}
+
+#ifdef DCM_TREE
+/*
+ * 功能：在树容器中查找能够容纳allocSize的最小的块。请求尺寸属于该容器时沿请求尺寸的比特位下降，
+ *      同时记录路径上没有进入的最深的右子树，其中的块都大于请求尺寸；之后沿最左路径查找子树中最小的块。
+ * 返回值：成功时返回0并通过pNode返回块节点（没有合适的块时为NULL），遇到坏块时返回-EFAULT。
+ */
+static int DCMTreeBestFit(DynamicCtnMan *dcm, DCMContainer *container, size_t allocSize, void **pNode)
+{
+    DCMTreeNode *tnode;
+    size_t index, holeSize, remain = SIZE_MAX;
+    uint64_t bits;
+    void *iterNode, *best = NULL, *rightTree = NULL, *right;
+
+    index = container - dcm->containers;
+    iterNode = container->root;
+    if (DCMLog2(allocSize) == index) {
+        bits = (uint64_t)allocSize << (64 - index);
+        for (; iterNode; bits <<= 1) {
+            if (!DCMTreeNodeIsValid(dcm, container, iterNode))
+                return -EFAULT;
+            holeSize = NODE_HOLE_SIZE(iterNode);
+            if (holeSize >= allocSize && holeSize - allocSize < remain) {
+                best = iterNode;
+                remain = holeSize - allocSize;
+                if (!remain)
+                    goto out;
+            }
+            tnode = NODE_TO_TNODE(iterNode);
+            right = tnode->child[1];
+            iterNode = tnode->child[bits >> 63];
+            if (right && right != iterNode)
+                rightTree = right;
+        }
+        iterNode = rightTree;
+    }
+    for (; iterNode; iterNode = tnode->child[0] ? tnode->child[0] : tnode->child[1]) {
+        if (!DCMTreeNodeIsValid(dcm, container, iterNode))
+            return -EFAULT;
+        holeSize = NODE_HOLE_SIZE(iterNode);
+        if (holeSize >= allocSize && holeSize - allocSize < remain) {
+            best = iterNode;
+            remain = holeSize - allocSize;
+        }
+        tnode = NODE_TO_TNODE(iterNode);
+    }
+out:
+    *pNode = best;
+    return 0;
+}
+
+/*
+ * 功能：从树容器中分配最佳适配的块，字典树中出现坏块时重建后再查找一次。
+ * 返回值：成功时返回可用的地址指针，否则返回NULL。
+ */
+static void *DCMTreeAlloc(DynamicCtnMan *dcm, DCMContainer *container, size_t allocSize)
+{
+    void *chunkNode;
+    uint8_t *chunkBase;
+
+    for (;;) {
+        if (DCMTreeBestFit(dcm, container, allocSize, &chunkNode) != 0) {
+            DCMTreeRebuild(dcm, container);
+            if (DCMTreeBestFit(dcm, container, allocSize, &chunkNode) != 0)
+                return NULL;
+        }
+        if (!chunkNode)
+            return NULL;
+        chunkBase = NODE_TO_CHUNK(chunkNode);
+#ifdef DCM_OOL_META
+        /*查找时只读取元数据，分配前再检查块本身。*/
+        if (!DCMChunkIsFree(dcm, chunkBase)) {
+            DCMContainerDropNode(dcm, container, chunkNode);
+            continue;
+        }
+#endif
+        DCMContainerChunkAlloc(dcm, container, chunkBase, allocSize);
+        return BASE_TO_LPOINTER(chunkBase);
+    }
+}
+#endif
+
+/*
+ * 功能：遍历容器中的块找到合适的块进行内存分配，树容器中分配最佳适配的块。
+ * 返回值：成功时返回可用的地址指针，否则返回NULL。
+ */
+static void *DCMContainerAlloc(DynamicCtnMan *dcm, DCMContainer *container, size_t allocSize)
+{
+    void *iterNode, *lastNode;
+    uint8_t *chunkBase;
+    uint8_t repeat = 0;
+
+#ifdef DCM_TREE
+    if (DCMContainerIsTree(dcm, container))
+        return DCMTreeAlloc(dcm, container, allocSize);
+#endif
+    lastNode = CONTAINER_NODE(container);
+    iterNode = container->next;
+    for ( ;iterNode != CONTAINER_NODE(container); ) {
+        if (!DCMNodeIsFree(dcm, iterNode)) {     /*从容器中删除无效块。*/
+            if (repeat == 0) {
+                repeat = 1;
+                PrDbg("next node [%p(H)] is invalide\n", iterNode);
+                iterNode = DCMSearchNextValidNode(dcm, container, lastNode);
+                if (iterNode == lastNode
+                        || CONTAINER_NODE(container) == iterNode)
+                    return NULL;
+            } else {    /*如果再次找到无效块则直接退出并返回NULL。*/
+                return NULL;
+            }
+        }
+
+        if (NODE_HOLE_SIZE(iterNode) >= allocSize) {
+            chunkBase = NODE_TO_CHUNK(iterNode);
+#ifdef DCM_OOL_META
+            /*遍历时只读取元数据，分配前再检查块本身。*/
+            if (!DCMChunkIsFree(dcm, chunkBase)) {
+                lastNode = NODE_GET_PREV(iterNode);
+                DCMContainerDropNode(dcm, container, iterNode);
+                iterNode = lastNode == CONTAINER_NODE(container) ? container->next : NODE_GET_NEXT(lastNode);
+                continue;
+            }
+#endif
+            DCMContainerChunkAlloc(dcm, container, chunkBase, allocSize);
+            return BASE_TO_LPOINTER(chunkBase);
+        }
+        lastNode = iterNode;
+        iterNode = NODE_GET_NEXT(iterNode);
+    }
+    return NULL;
+}
+
+/*
+ * 功能：把请求的内存尺寸转换为块的窗口尺寸。块释放后需要容纳前后链接指针，
+ *      因此窗口尺寸不能小于最小块的窗口尺寸。
+ * 返回值：窗口尺寸
+ */
+static inline size_t DCMHoleSize(size_t size)
+{
+    if (size < CHUNK_SIZE_TO_HOLE_SIZE(CHUNK_MIN_SIZE))
+        return CHUNK_SIZE_TO_HOLE_SIZE(CHUNK_MIN_SIZE);
+    return CHUNK_SIZE_ROUND_UP(size);
+}
+
+#ifdef DCM_TLSF
+/*
+ * 功能：根据一级和二级位图找到第一个非空且其中所有块都能容纳size的子容器，并从中分配。
+ *      请求尺寸先向上取整到下一个子容器的起始尺寸，因此子容器中的第一个块即可满足请求。
+ * 返回值：成功时返回0并通过pPointer返回地址指针（没有合适的子容器时为NULL），
+ *      选中的子容器中没有有效块时返回-EFAULT。
+ */
+static int DCMTlsfAlloc(DynamicCtnMan *dcm, size_t size, void **pPointer)
+{
+    size_t fl, sl, search = size;
+    uint32_t slMap;
+    uint64_t flMap;
+
+    *pPointer = NULL;
+    if (search >= DCM_SMALL_SIZE)
+        search += ((size_t)1 << (DCMLog2(search) - DCM_SL_LOG2)) - 1;
+    DCMTlsfMapping(search, &fl, &sl);
+    if (fl >= DCM_FL_COUNT)
+        return 0;
+    slMap = dcm->slBitmap[fl] & (~0U << sl);
+    if (!slMap) {
+        flMap = fl + 1 < DCM_FL_COUNT ? dcm->flBitmap & (~(uint64_t)0 << (fl + 1)) : 0;
+        if (!flMap)
+            return 0;
+        fl = CplCtz64(flMap);
+        slMap = dcm->slBitmap[fl];
+    }
+    sl = CplCtz64(slMap);
+    *pPointer = DCMContainerAlloc(dcm, &dcm->containers[fl * DCM_SL_COUNT + sl], size);
+    return *pPointer ? 0 : -EFAULT;
+}
+#endif
+
+static int DCMAddRegionInternal(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen, unsigned int flags);
+
+/*
+ * 功能：调用扩展回调获取能够容纳holeSize窗口的新区域，调用者持有管理器锁。
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+static int DCMGrow(DynamicCtnMan *dcm, size_t holeSize)
+{
+    size_t size = 0;
+    uint8_t *buffer;
+
+    if (!dcm->grow || dcm->regionCount >= DCM_MAX_REGIONS)
+        return -ENOMEM;
+    /*额外预留区域末尾的哨兵和基地址对齐的余量。*/
+    buffer = dcm->grow(dcm->growArg, HOLE_SIZE_TO_CHUNK_SIZE(holeSize) + BOUNDARY_MARKER_SIZE + MEM_MAN_ALIGN_SIZE, &size);
+    if (!buffer)
+        return -ENOMEM;
+    return DCMAddRegionInternal(dcm, buffer, size, dcm->growFlags);
+}
+
+/*
+ * 功能：从管理器现有的块中分配size大小的内存，先查找容器，再从顶块切分，调用者持有管理器锁。
+ * 返回值：成功时返回可用的地址指针，否则返回NULL。
+ */
+static void *DCMAllocFit(DynamicCtnMan *dcm, size_t size)
+{
+    size_t pos;
+    size_t i;
+    void *pointer;
+#ifndef DCM_TLSF
+    uint64_t binMap;
+#endif
+
+    size = DCMHoleSize(size);
+#ifdef DCM_TLSF
+    pos = DCMSelectChunkContainer(dcm, HOLE_SIZE_TO_CHUNK_SIZE(size)) - dcm->containers;
+    if (DCMTlsfAlloc(dcm, size, &pointer) == 0) {
+        if (pointer)
+            return pointer;
+        /*位图中没有保证满足请求的子容器时，先从顶块切分，
+            再只在请求尺寸所在的子容器中逐个查找可能满足请求的块。*/
+        pointer = DCMTopAlloc(dcm, size);
+        if (pointer)
+            return pointer;
+        return DCMContainerAlloc(dcm, &dcm->containers[pos], size);
+    }
+    /*位图选中的子容器中的块无效时，从请求尺寸所在的子容器开始逐个查找。*/
+    for (i = pos; i < ARRAY_SIZE(dcm->containers); i++) {
+        pointer = DCMContainerAlloc(dcm, &dcm->containers[i], size);
+        if (pointer)
+            return pointer;
+    }
+#else
+    /*根据请求的内存大小选择合适的容器，并通过容器位图直接跳过空容器；
+      如果当前容器返回NULL，则继续从下一个非空容器分配内存。*/
+    pos = DCMLog2(size);
+    binMap = dcm->binBitmap & (~(uint64_t)0 << pos);
+    for (; binMap; binMap &= binMap - 1) {
+        i = CplCtz64(binMap);
+        pointer = DCMContainerAlloc(dcm, &dcm->containers[i], size);
+        if (pointer)
+            return pointer;
+    }
+#endif
+    /*容器中没有合适的块时从顶块切分。*/
+    return DCMTopAlloc(dcm, size);
+}
+
+/*
+ * 功能：从管理器分配size大小的内存，现有的块无法满足时扩展堆区，调用者持有管理器锁。
+ * 返回值：成功时返回可用的地址指针，否则返回NULL。
+ */
+static void *DCMAllocInternal(DynamicCtnMan *dcm, size_t size)
+{
+    void *pointer;
+
+    if ((uint64_t)size > CHUNK_SIZE_TO_HOLE_SIZE(CHUNK_MAX_SIZE))
+        return NULL;
+    pointer = DCMAllocFit(dcm, size);
+    if (!pointer && DCMGrow(dcm, DCMHoleSize(size)) == 0)
+        pointer = DCMAllocFit(dcm, size);
+    return pointer;
+}
+
+/*
+ * 功能：校验时判断节点是否代表有效的块，DCM_OOL_META模式下还要求元数据表项与块相互对应，调用者持有管理器锁。
+ * 返回值：有效返回1，否则返回0。
+ */
+static char DCMVerifyNode(DynamicCtnMan *dcm, void *chunkNode)
+{
+#ifdef DCM_OOL_META
+    uint8_t *chunkBase;
+
+    if (!DCMMetaAddressIsValid(dcm, chunkNode))
+        return 0;
+    chunkBase = NODE_TO_CHUNK(chunkNode);
+    if (!DCMAddressIsValid(dcm, chunkBase)
+            || CHUNK_NODE(chunkBase) != chunkNode
+            || ((DCMMeta *)chunkNode)->chunkSize != BASE_TO_LMARKER(chunkBase)->chunkSize)
+        return 0;
+#endif
+    return DCMChunkIsValid(dcm, NODE_TO_CHUNK(chunkNode));
+}
+
+#ifdef DCM_TREE
+/*
+ * 功能：校验树容器链表中的块与字典树一致：重复块紧随同尺寸的块；树中的块沿父节点能够上溯到根节点，
+ *      且每条边的方向与块窗口尺寸中对应的比特位一致。调用者持有管理器锁。
+ * 返回值：一致返回0，否则返回-EFAULT。
+ */
+static int DCMTreeVerifyNode(DynamicCtnMan *dcm, DCMContainer *container, void *chunkNode, void *lastNode)
+{
+    size_t index, holeSize, depth;
+    void *iterNode, *parent;
+
+    holeSize = NODE_HOLE_SIZE(chunkNode);
+    if (!NODE_TO_TNODE(chunkNode)->parent) {
+        if (lastNode == CONTAINER_NODE(container)
+                || NODE_HOLE_SIZE(lastNode) != holeSize)
+            return -EFAULT;
+        return 0;
+    }
+
+    index = container - dcm->containers;
+    for (depth = 0, iterNode = chunkNode; NODE_TO_TNODE(iterNode)->parent != CONTAINER_NODE(container); depth++) {
+        iterNode = NODE_TO_TNODE(iterNode)->parent;
+        if (depth >= index || !DCMVerifyNode(dcm, iterNode))
+            return -EFAULT;
+    }
+    if (container->root != iterNode)
+        return -EFAULT;
+    for (iterNode = chunkNode; depth > 0; depth--) {
+        parent = NODE_TO_TNODE(iterNode)->parent;
+        if (NODE_TO_TNODE(parent)->child[(holeSize >> (index - depth)) & 1] != iterNode)
+            return -EFAULT;
+        iterNode = parent;
+    }
+    return 0;
+}
+
+/*
+ * 功能：按深度优先顺序统计字典树中的块数量，调用者持有管理器锁。
+ * limit: 块数量上限，超过时说明字典树成环
+ * 返回值：块数量，字典树损坏时返回SIZE_MAX。
+ */
+static size_t DCMTreeCount(DynamicCtnMan *dcm, DCMContainer *container, size_t limit)
+{
+    DCMTreeNode *tnode;
+    void *iterNode, *parent;
+    size_t count = 0, depth = 0;
+
+    for (iterNode = container->root; iterNode; ) {
+        if (++count > limit || !DCMVerifyNode(dcm, iterNode))
+            return SIZE_MAX;
+        tnode = NODE_TO_TNODE(iterNode);
+        if (tnode->child[0] || tnode->child[1]) {
+            iterNode = tnode->child[0] ? tnode->child[0] : tnode->child[1];
+            depth++;
+            continue;
+        }
+        /*叶子节点：上溯到第一个从左子树返回且有右子树的祖先，进入其右子树。*/
+        for (;;) {
+            if (!depth)
+                return count;
+            parent = NODE_TO_TNODE(iterNode)->parent;
+            depth--;
+            if (NODE_TO_TNODE(parent)->child[0] == iterNode && NODE_TO_TNODE(parent)->child[1]) {
+                iterNode = NODE_TO_TNODE(parent)->child[1];
+                depth++;
+                break;
+            }
+            iterNode = parent;
+        }
+    }
+    return count;
+}
+#endif
+
+/*
+ * 功能：按物理地址顺序遍历堆区中的所有块，并校验容器链表，调用者持有管理器锁。
+ *      检查项：块尺寸有效且首尾相接覆盖整个堆区；prevUsed标志与左相邻块一致；
+ *      空闲块的左右边界标记和校验信息正确；没有相邻的空闲块；容器链表中的块都是空闲块且位于正确的容器中，前后链接一致；
+ *      链表中的块数量等于堆区中除顶块以外的空闲块数量；顶块结束于顶块区域末尾；树容器的链表与字典树一致。
+ * 返回值：堆区完整返回0，否则返回-EFAULT。
+ */
+static int DCMVerifyInternal(DynamicCtnMan *dcm)
+{
+    uint8_t *chunkBase, *memEnd;
+    DCMBoundaryMarker *leftMarker, *rightMarker;
+    DCMContainer *container;
+    void *iterNode, *lastNode;
+    size_t freeCount = 0, listCount = 0, n, i;
+    unsigned int r;
+    char lastFree, topFound = 0;
+#ifdef DCM_TREE
+    size_t treeCount;
+#endif
+
+    for (r = 0; r < dcm->regionCount; r++) {
+        lastFree = 0;
+        memEnd = dcm->regions[r].base + dcm->regions[r].size;
+        for (chunkBase = dcm->regions[r].base; chunkBase < memEnd; chunkBase += leftMarker->chunkSize) {
+            leftMarker = BASE_TO_LMARKER(chunkBase);
+            if (!DCMChunkSizeIsValid(dcm, chunkBase)
+                    || leftMarker->prevUsed == lastFree)
+                return -EFAULT;
+            if (leftMarker->used == 0) {
+                rightMarker = BASE_TO_RMARKER(chunkBase);
+                if (lastFree
+                        || !DCMChunkIsValid(dcm, chunkBase)
+                        || leftMarker->checksum != rightMarker->checksum
+                        || leftMarker->checksum != DCMChunkChecksum(dcm, chunkBase))
+                    return -EFAULT;
+                if (chunkBase == dcm->top) {
+                    /*顶块不在容器中。*/
+                    if (chunkBase + leftMarker->chunkSize != dcm->topEnd)
+                        return -EFAULT;
+                    topFound = 1;
+                } else {
+#ifdef DCM_OOL_META
+                    /*孤立块不在容器中。*/
+                    if (CHUNK_NODE(chunkBase))
+#endif
+                    freeCount++;
+                }
+            }
+            lastFree = !leftMarker->used;
+        }
+        /*区域末尾的哨兵必须是已使用状态。*/
+        if (chunkBase != memEnd
+                || !BASE_TO_LMARKER(memEnd)->used
+                || BASE_TO_LMARKER(memEnd)->prevUsed == lastFree)
+            return -EFAULT;
+    }
+    if (dcm->top && !topFound)
+        return -EFAULT;
+
+    for (i = 0; i < ARRAY_SIZE(dcm->containers); i++) {
+        container = &dcm->containers[i];
+        lastNode = CONTAINER_NODE(container);
+        iterNode = container->next;
+#ifdef DCM_TREE
+        treeCount = 0;
+#endif
+        for (n = 0; iterNode != CONTAINER_NODE(container); n++) {
+            /*链表中的块数量超过空闲块数量说明链表成环。*/
+            if (listCount + n >= freeCount
+                    || !DCMVerifyNode(dcm, iterNode))
+                return -EFAULT;
+            chunkBase = NODE_TO_CHUNK(iterNode);
+            if (BASE_TO_LMARKER(chunkBase)->used
+                    || DCMSelectChunkContainer(dcm, BASE_TO_LMARKER(chunkBase)->chunkSize) != container
+                    || NODE_GET_PREV(iterNode) != lastNode)
+                return -EFAULT;
+#ifdef DCM_TREE
+            if (DCMContainerIsTree(dcm, container)) {
+                if (DCMTreeVerifyNode(dcm, container, iterNode, lastNode) != 0)
+                    return -EFAULT;
+                treeCount += NODE_TO_TNODE(iterNode)->parent != NULL;
+            }
+#endif
+            lastNode = iterNode;
+            iterNode = NODE_GET_NEXT(iterNode);
+        }
+        if (container->prev != lastNode)
+            return -EFAULT;
+#ifdef DCM_TREE
+        /*树中的块都在链表中，且数量一致。*/
+        if (DCMContainerIsTree(dcm, container)
+                && DCMTreeCount(dcm, container, treeCount) != treeCount)
+            return -EFAULT;
+#endif
+        listCount += n;
+    }
+    return listCount == freeCount ? 0 : -EFAULT;
+}
+
+/*
+ * 功能：DCM_CHECK_AUDIT级别下每隔auditPeriod次操作校验整个堆区，调用者持有管理器锁。
+ * 返回值：无
+ */
+static inline void DCMAudit(DynamicCtnMan *dcm)
+{
+    if (dcm->checkLevel != DCM_CHECK_AUDIT
+            || ++dcm->auditCount < dcm->auditPeriod)
+        return;
+    dcm->auditCount = 0;
+    if (DCMVerifyInternal(dcm) != 0)
+        printf("heap [%p(H)] is corrupted\n", dcm);
+}
+
+/*
+ * 功能：从管理器分配size大小的内存。
+ * 返回值：成功时返回可用的地址指针，否则返回NULL。
+ */
+void *DCMAlloc(DynamicCtnMan *dcm, size_t size)
+{
+    void *pointer;
+
+    CplLockAcquire(&dcm->lock);
+    pointer = DCMAllocInternal(dcm, size);
+    DCMAudit(dcm);
+    CplLockRelease(&dcm->lock);
+    return pointer;
+}
+
+/*
+ * 功能：从管理器一次分配最多n个size大小的内存，整个过程只获取一次管理器锁。
+ *      优先分配一个能够容纳n个块的大块并切分为n个相邻的已分配块，失败时逐个分配。
+ * out: 保存分配到的地址指针
+ * 返回值：分配到的内存数量
+ */
+unsigned int DCMAllocBatch(DynamicCtnMan *dcm, size_t size, void **out, unsigned int n)
+{
+    DCMBoundaryMarker *leftMarker;
+    uint8_t *chunkBase, *blockEnd;
+    size_t chunkSize;
+    unsigned int i = 0;
+
+    if (!n || (uint64_t)size > CHUNK_SIZE_TO_HOLE_SIZE(CHUNK_MAX_SIZE))
+        return 0;
+    chunkSize = HOLE_SIZE_TO_CHUNK_SIZE(DCMHoleSize(size));
+    CplLockAcquire(&dcm->lock);
+    if (n > 1 && chunkSize <= CHUNK_MAX_SIZE / n
+            && (out[0] = DCMAllocInternal(dcm, CHUNK_SIZE_TO_HOLE_SIZE(chunkSize * n)))) {
+        /*大块的右相邻块已记录左相邻块被使用，切分出的块都是已分配块，不需要右边界标记，
+            最后一个块包含分配时无法切分的剩余部分。*/
+        chunkBase = LPOINTER_TO_BASE(out[0]);
+        leftMarker = BASE_TO_LMARKER(chunkBase);
+        blockEnd = chunkBase + leftMarker->chunkSize;
+        leftMarker->chunkSize = chunkSize;
+        leftMarker->zeroed = 0;
+        for (i = 1; i < n; i++) {
+            chunkBase += chunkSize;
+            leftMarker = BASE_TO_LMARKER(chunkBase);
+            leftMarker->used = 1;
+            leftMarker->prevUsed = 1;
+            leftMarker->zeroed = 0;
+            leftMarker->checksum = CHUNK_CS_DEFAULT_VAL;
+            leftMarker->chunkSize = i == n - 1 ? (size_t)(blockEnd - chunkBase) : chunkSize;
+            out[i] = BASE_TO_LPOINTER(chunkBase);
+        }
+    } else {
+        for (i = 0; i < n && (out[i] = DCMAllocInternal(dcm, size)); i++)
+            ;
+    }
+    DCMAudit(dcm);
+    CplLockRelease(&dcm->lock);
+    return i;
+}
+
+/*
+ * 功能：向管理器释放pointer指向的内存空间，调用者持有管理器锁。
+ * 返回值：无
+ */
+static void DCMFreeInternal(DynamicCtnMan *dcm, void *pointer)
+{
+    uint8_t *chunkBase;
+    DCMBoundaryMarker *leftMarker;
+    DCMBoundaryMarker *lNbRMarker, *rNbLMarker;
+    char lNbUsed = 1, rNbUsed = 1;
+    size_t freeChunkSize;
+    uint8_t *freeChunkBase;
+
+    if (!pointer)
+        return;
+    /*根据待释放指针，获取被释放块的基地址和相邻块的使用信息。
+        如果相邻块是空闲的，则进行合并。*/
+    chunkBase = LPOINTER_TO_BASE(pointer);
+    if (dcm->checkLevel != DCM_CHECK_NONE
+            && !DCMUsedChunkIsValid(dcm, chunkBase)) {
+        PrDbg("node [%p(H)] is invalide\n", chunkBase);
+        return;
+    }
+
+    leftMarker = BASE_TO_LMARKER(chunkBase);
+    lNbRMarker = CHUNK_LNB_RMARKER(chunkBase);
+    rNbLMarker = CHUNK_RNB_LMARKER(chunkBase);
+
+    /*判断相邻块是否有效且空闲。只有左相邻块空闲时，其右边界标记才存在；区域第一个块的prevUsed
+        总为1，区域末尾的哨兵总是已使用，因此合并不会越过区域边界。*/
+    if (!leftMarker->prevUsed) {
+        if (DCMChunkIsFree(dcm, RMARKER_TO_BASE(lNbRMarker))) {
+            lNbUsed = 0;
+        }
+    }
+    if (DCMChunkIsFree(dcm, LMARKER_TO_BASE(rNbLMarker))) {
+        rNbUsed = 0;
+    }
+
+    /*从管理器中删除有效相邻空闲块，并跟被释放块合并到一起添加到管理器中。*/
+    if (lNbUsed == 0 && rNbUsed == 0) {
+        freeChunkSize = lNbRMarker->chunkSize + leftMarker->chunkSize + rNbLMarker->chunkSize;
+        freeChunkBase = RMARKER_TO_BASE(lNbRMarker);
+        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, lNbRMarker->chunkSize), RMARKER_TO_BASE(lNbRMarker));
+        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, rNbLMarker->chunkSize), LMARKER_TO_BASE(rNbLMarker));
+    } else if (lNbUsed == 0) {
+        freeChunkSize = lNbRMarker->chunkSize + leftMarker->chunkSize;
+        freeChunkBase = RMARKER_TO_BASE(lNbRMarker);
+        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, lNbRMarker->chunkSize), RMARKER_TO_BASE(lNbRMarker));
+    } else if (rNbUsed == 0) {
+        freeChunkSize = leftMarker->chunkSize + rNbLMarker->chunkSize;
+        freeChunkBase = chunkBase;
+        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, rNbLMarker->chunkSize), LMARKER_TO_BASE(rNbLMarker));
+    } else {
+        freeChunkBase = chunkBase;
+        freeChunkSize = leftMarker->chunkSize;
+    }
+    if (freeChunkSize >= dcm->purgeMinSize)
+        dcm->purgeDirty += leftMarker->chunkSize;
+    DCMAddChunk(dcm, freeChunkBase, freeChunkSize);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+/*
+ * 功能：把可归还区域中的一个空闲块内部按页对齐的部分通过madvise还给系统，调用者持有管理器锁。
+ *      被归还的页再次访问时内容为0，因此把块首尾未对齐的部分也清零，
+ *      并设置块的清零标志，DCMCalloc分配这些块时无需再清零。
+ * 返回值：归还的字节数
+ */
+static size_t DCMPurgeChunk(DynamicCtnMan *dcm, uint8_t *chunkBase, size_t pageSize)
+{
+    DCMBoundaryMarker *leftMarker = BASE_TO_LMARKER(chunkBase);
+    DCMRegion *region = DCMFindRegion(dcm, chunkBase);
+    uint8_t *dataStart, *dataEnd, *pageStart, *pageEnd;
+
+    if (!region || !(region->flags & DCM_FLAG_PURGEABLE))
+        return 0;
+    /*损坏的块尺寸可能越过区域末尾，不归还。*/
+    if (leftMarker->used || leftMarker->zeroed
+            || leftMarker->chunkSize < dcm->purgeMinSize
+            || leftMarker->chunkSize > (size_t)(region->base + region->size - chunkBase))
+        return 0;
+    /*保留边界标记和节点指针。*/
+    dataStart = CHUNK_CS_DATA_ADDR(chunkBase);
+    dataEnd = dataStart + CHUNK_CS_DATA_LEN(chunkBase);
+    pageStart = dataStart + (pageSize - (size_t)dataStart % pageSize) % pageSize;
+    pageEnd = dataEnd - (size_t)dataEnd % pageSize;
+    if (pageEnd <= pageStart)
+        return 0;
+    if (madvise(pageStart, pageEnd - pageStart, MADV_DONTNEED) != 0)
+        return 0;
+    memset(dataStart, 0, pageStart - dataStart);
+    memset(pageEnd, 0, dataEnd - pageEnd);
+    leftMarker->zeroed = 1;
+    /*数据区全为0，校验和为0。*/
+    leftMarker->checksum = dcm->checkLevel >= DCM_CHECK_CHECKSUM ? 0 : CHUNK_CS_DEFAULT_VAL;
+    BASE_TO_RMARKER(chunkBase)->checksum = leftMarker->checksum;
+    return pageEnd - pageStart;
+}
+#endif
+
+/*
+ * 功能：把可归还区域中不小于purgeMinSize的空闲块的物理页还给系统，调用者持有管理器锁。
+ *      只遍历可能含有这类块的容器和顶块，不按物理地址遍历整个区域，
+ *      已使用的块和小块不影响耗时。
+ *      定义DCM_OOL_META时，没有元数据表项的孤立块不在容器中，不会被归还。
+ * 返回值：归还的字节数
+ */
+static size_t DCMPurgeInternal(DynamicCtnMan *dcm)
+{
+    size_t purged = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t minSize, i;
+    DCMContainer *container;
+    void *iterNode;
+    unsigned int r;
+
+    dcm->purgeDirty = 0;
+    for (r = 0; r < dcm->regionCount; r++) {
+        if (dcm->regions[r].flags & DCM_FLAG_PURGEABLE)
+            break;
+    }
+    if (r == dcm->regionCount)
+        return 0;
+    if (dcm->top)
+        purged += DCMPurgeChunk(dcm, dcm->top, pageSize);
+    /*purgeMinSize所在容器中的块可能更小，由DCMPurgeChunk逐个判断，之后的容器中的块都更大。*/
+    minSize = dcm->purgeMinSize;
+    if (minSize < CHUNK_MIN_SIZE)
+        minSize = CHUNK_MIN_SIZE;
+    if (minSize > CHUNK_MAX_SIZE)
+        minSize = CHUNK_MAX_SIZE;
+    for (i = DCMSelectChunkContainer(dcm, minSize) - dcm->containers; i < ARRAY_SIZE(dcm->containers); i++) {
+        container = &dcm->containers[i];
+        /*只改变块的清零标志和校验和，块仍留在原容器中，遍历链表即可覆盖树容器中的块。*/
+        for (iterNode = container->next; iterNode != CONTAINER_NODE(container); iterNode = NODE_GET_NEXT(iterNode)) {
+#ifdef DCM_OOL_META
+            /*遇到损坏的元数据时无法继续遍历该容器。*/
+            if (dcm->checkLevel != DCM_CHECK_NONE && !DCMMetaAddressIsValid(dcm, iterNode))
+                break;
+#endif
+            purged += DCMPurgeChunk(dcm, NODE_TO_CHUNK(iterNode), pageSize);
+        }
+    }
+#else
+    (void)dcm;
+#endif
+    return purged;
+}
+
+/*
+ * 功能：向管理器释放pointer指向的内存空间。
+ * 返回值：无
+ */
+void DCMFree(DynamicCtnMan *dcm, void *pointer)
+{
+    if (!pointer)
+        return;
+    CplLockAcquire(&dcm->lock);
+    DCMFreeInternal(dcm, pointer);
+    if (dcm->purgeThreshold && dcm->purgeDirty >= dcm->purgeThreshold)
+        DCMPurgeInternal(dcm);
+    DCMAudit(dcm);
+    CplLockRelease(&dcm->lock);
+}
+
+/*
+ * 功能：向管理器一次释放ptrs中的n个内存空间，整个过程只获取一次管理器锁，NULL被忽略。
+ *      ptrs中连续的指针指向物理相邻的已分配块时，先合并为一个块再释放，
+ *      因此按地址升序排列的指针（如DCMAllocBatch的结果）只需合并一次相邻空闲块。
+ * 返回值：无
+ */
+void DCMFreeBatch(DynamicCtnMan *dcm, void * const *ptrs, unsigned int n)
+{
+    DCMBoundaryMarker *leftMarker, *nextMarker;
+    uint8_t *chunkBase;
+    unsigned int i, j;
+
+    CplLockAcquire(&dcm->lock);
+    for (i = 0; i < n; i = j) {
+        j = i + 1;
+        if (!ptrs[i])
+            continue;
+        chunkBase = LPOINTER_TO_BASE(ptrs[i]);
+        if (dcm->checkLevel != DCM_CHECK_NONE
+                && !DCMUsedChunkIsValid(dcm, chunkBase)) {
+            PrDbg("node [%p(H)] is invalide\n", chunkBase);
+            continue;
+        }
+        leftMarker = BASE_TO_LMARKER(chunkBase);
+        for (; j < n && ptrs[j] == BASE_TO_LPOINTER(chunkBase + leftMarker->chunkSize); j++) {
+            nextMarker = CHUNK_RNB_LMARKER(chunkBase);
+            if ((dcm->checkLevel != DCM_CHECK_NONE
+                        && !DCMUsedChunkIsValid(dcm, LMARKER_TO_BASE(nextMarker)))
+                    || (uint64_t)leftMarker->chunkSize + nextMarker->chunkSize > CHUNK_MAX_SIZE)
+                break;
+            leftMarker->chunkSize += nextMarker->chunkSize;
+        }
+        DCMFreeInternal(dcm, ptrs[i]);
+    }
+    if (dcm->purgeThreshold && dcm->purgeDirty >= dcm->purgeThreshold)
+        DCMPurgeInternal(dcm);
+    DCMAudit(dcm);
+    CplLockRelease(&dcm->lock);
+}
+
+/*
+ * 功能：把已分配块的尾部切分为独立的块并释放，尾部会和右相邻的空闲块合并。
+ *      调用者持有管理器锁。
+ * holeSize: 保留的窗口尺寸
+ * 返回值：无
+ */
+static void DCMChunkTrim(DynamicCtnMan *dcm, uint8_t *chunkBase, size_t holeSize)
+{
+    DCMBoundaryMarker *leftMarker, *tailMarker;
+    size_t remain;
+
+    leftMarker = BASE_TO_LMARKER(chunkBase);
+    remain = leftMarker->chunkSize - HOLE_SIZE_TO_CHUNK_SIZE(holeSize);
+    if (remain < CHUNK_MIN_SIZE)
+        return;
+    leftMarker->chunkSize = HOLE_SIZE_TO_CHUNK_SIZE(holeSize);
+    /*把尾部写成已分配块，再按正常流程释放。*/
+    tailMarker = CHUNK_RNB_LMARKER(chunkBase);
+    tailMarker->used = 1;
+    tailMarker->prevUsed = 1;
+    tailMarker->chunkSize = remain;
+    DCMFreeInternal(dcm, BASE_TO_LPOINTER(LMARKER_TO_BASE(tailMarker)));
+}
+
+/*
+ * 功能：调整pointer指向的内存空间的尺寸，调用者持有管理器锁。
+ *      缩小时把尾部释放回管理器；扩大时优先合并右相邻的空闲块，
+ *      否则重新分配内存并复制原有数据。
+ * 返回值：成功时返回调整后的地址指针，否则返回NULL，原有内存空间不变。
+ */
+static void *DCMReallocInternal(DynamicCtnMan *dcm, void *pointer, size_t size)
+{
+    uint8_t *chunkBase, *rNbBase;
+    DCMBoundaryMarker *leftMarker, *rNbLMarker;
+    size_t holeSize;
+    void *newPointer;
+
+    chunkBase = LPOINTER_TO_BASE(pointer);
+    if (dcm->checkLevel != DCM_CHECK_NONE
+            && !DCMUsedChunkIsValid(dcm, chunkBase)) {
+        PrDbg("node [%p(H)] is invalide\n", chunkBase);
+        return NULL;
+    }
+    if ((uint64_t)size > CHUNK_SIZE_TO_HOLE_SIZE(CHUNK_MAX_SIZE))
+        return NULL;
+    leftMarker = BASE_TO_LMARKER(chunkBase);
+    holeSize = DCMHoleSize(size);
+
+    /*原地缩小。*/
+    if (holeSize <= CHUNK_HOLE_SIZE(chunkBase)) {
+        DCMChunkTrim(dcm, chunkBase, holeSize);
+        return pointer;
+    }
+
+    /*右相邻块空闲且合并后能够容纳请求尺寸时原地扩大。*/
+    rNbLMarker = CHUNK_RNB_LMARKER(chunkBase);
+    rNbBase = LMARKER_TO_BASE(rNbLMarker);
+    if (DCMChunkIsFree(dcm, rNbBase)
+            && CHUNK_HOLE_SIZE(chunkBase) + rNbLMarker->chunkSize >= holeSize) {
+        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, rNbLMarker->chunkSize), rNbBase);
+        leftMarker->chunkSize += rNbLMarker->chunkSize;
+        DCMChunkSetRNbPrevUsed(dcm, chunkBase, 1);
+        DCMChunkTrim(dcm, chunkBase, holeSize);
+        return pointer;
+    }
+
+    newPointer = DCMAllocInternal(dcm, size);
+    if (!newPointer)
+        return NULL;
+    memcpy(newPointer, pointer, CHUNK_HOLE_SIZE(chunkBase));
+    DCMFreeInternal(dcm, pointer);
+    return newPointer;
+}
+
+/*
+ * 功能：调整pointer指向的内存空间的尺寸。pointer为NULL时等同于DCMAlloc，
+ *      size为0时等同于DCMFree并返回NULL。
+ * 返回值：成功时返回调整后的地址指针，否则返回NULL，原有内存空间不变。
+ */
+void *DCMRealloc(DynamicCtnMan *dcm, void *pointer, size_t size)
+{
+    void *newPointer;
 
-        leftMarker->chunkSize = allocSize + BOUNDARY_MARKER_SIZE * 2;
-        rightMarker = BASE_TO_RMARKER(chunkBase);
-        rightMarker->chunkSize = leftMarker->chunkSize;
-        newChunkBase = chunkBase + leftMarker->chunkSize;
-        DCMAddChunk(dcm, newChunkBase, remain);
-    } else {
-        rightMarker = BASE_TO_RMARKER(chunkBase);
+    if (!pointer)
+        return DCMAlloc(dcm, size);
+    if (size == 0) {
+        DCMFree(dcm, pointer);
+        return NULL;
     }
-    leftMarker->used = 1;
-    rightMarker->used = 1;
+    CplLockAcquire(&dcm->lock);
+    newPointer = DCMReallocInternal(dcm, pointer, size);
+    DCMAudit(dcm);
+    CplLockRelease(&dcm->lock);
+    return newPointer;
 }
 
 /*
- * 功能：遍历容器中的块找到合适的块进行内存分配。
+ * 功能：从管理器分配size大小、按align对齐的内存，调用者持有管理器锁。
+ *      先分配一个足以容纳对齐后区域的块，再把对齐地址之前的部分作为独立的空闲块
+ *      放回管理器，最后释放多余的尾部。
  * 返回值：成功时返回可用的地址指针，否则返回NULL。
  */
-static void *DCMContainerAlloc(DynamicCtnMan *dcm, DCMContainer *container, size_t allocSize)
+static void *DCMAllocAlignedInternal(DynamicCtnMan *dcm, size_t size, size_t align)
 {
-    void *iterNode, *lastNode;
-    uint8_t *chunkBase;
-    uint8_t repeat = 0;
-
-    lastNode = CONTAINER_NODE(container);
-    iterNode = container->next;
-    for ( ;iterNode != CONTAINER_NODE(container); ) {
-        chunkBase = NODE_TO_CHUNK(iterNode);
-        if (!DCMChunkIsFree(dcm, chunkBase)) {     /*从容器中删除无效块。*/
-            if (repeat == 0) {
-                repeat = 1;
-                PrDbg("next node [%p(H)] is invalide\n", chunkBase);
-                iterNode = DCMSearchNextValidNode(dcm, container, lastNode);
-                if (iterNode == lastNode
-                        || CONTAINER_NODE(container) == iterNode)
-                    return NULL;
-                chunkBase = NODE_TO_CHUNK(iterNode);
-            } else {    /*如果再次找到无效块则直接退出并返回NULL。*/
-                return NULL;
-            }
-        }
-        lastNode = iterNode;
-
-        if (CHUNK_HOLE_SIZE(chunkBase) >= allocSize) {
-            DCMContainerChunkAlloc(dcm, container, chunkBase, allocSize);
-            return iterNode;
-        }
-        iterNode = CHUNK_GET_NEXT_NODE(chunkBase);
+    uint8_t *pointer, *aligned, *chunkBase;
+    size_t holeSize, gap;
+
+    if ((uint64_t)size > CHUNK_SIZE_TO_HOLE_SIZE(CHUNK_MAX_SIZE) - align - CHUNK_MIN_SIZE)
+        return NULL;
+    holeSize = DCMHoleSize(size);
+    /*前部剩余空间要么为0，要么足以构成一个最小块。*/
+    pointer = DCMAllocInternal(dcm, holeSize + align + CHUNK_MIN_SIZE);
+    if (!pointer)
+        return NULL;
+    aligned = pointer + (align - (size_t)pointer % align) % align;
+    while (aligned != pointer && (size_t)(aligned - pointer) < CHUNK_MIN_SIZE)
+        aligned += align;
+
+    chunkBase = LPOINTER_TO_BASE(aligned);
+    gap = aligned - pointer;
+    if (gap) {
+        /*写入对齐块的左边界标记，再把前部作为空闲块添加到管理器中，
+            添加时会清除对齐块的prevUsed标志。*/
+        BASE_TO_LMARKER(chunkBase)->used = 1;
+        BASE_TO_LMARKER(chunkBase)->zeroed = 0;
+        BASE_TO_LMARKER(chunkBase)->chunkSize = BASE_TO_LMARKER(LPOINTER_TO_BASE(pointer))->chunkSize - gap;
+        DCMAddChunk(dcm, LPOINTER_TO_BASE(pointer), gap);
     }
-    return NULL;
+    DCMChunkTrim(dcm, chunkBase, holeSize);
+    return aligned;
 }
 
 /*
- * 功能：从管理器分配size大小的内存。
+ * 功能：从管理器分配size大小、按align对齐的内存。
+ * align: 对齐尺寸，需要是2的幂
  * 返回值：成功时返回可用的地址指针，否则返回NULL。
  */
-void *DCMAlloc(DynamicCtnMan *dcm, size_t size)
+void *DCMAllocAligned(DynamicCtnMan *dcm, size_t size, size_t align)
 {
-    size_t pos;
-    size_t i;
     void *pointer;
 
-    if (size == 0)
-        size = 1;
-    size = CHUNK_SIZE_ROUND_UP(size);
-    pos = DCMLog2(size);
-    /*根据请求的内存大小选择合适的容器，如果当前容器返回NULL，则继续从下一级容器分配内测。*/
-    for (i = pos; i < ARRAY_SIZE(dcm->containers); i++) {
-        pointer = DCMContainerAlloc(dcm, &dcm->containers[i], size);
-        if (pointer)
-            return pointer;
+    if (!align || (align & (align - 1)))
+        return NULL;
+    if (align <= MEM_MAN_ALIGN_SIZE)
+        return DCMAlloc(dcm, size);
+    CplLockAcquire(&dcm->lock);
+    pointer = DCMAllocAlignedInternal(dcm, size, align);
+    DCMAudit(dcm);
+    CplLockRelease(&dcm->lock);
+    return pointer;
+}
+
+/*
+ * 功能：从管理器分配size大小并清零的内存。块的清零状态有效时只需清除块作为空闲块时
+ *      写入的节点指针和右边界标记，否则清零整个请求区域。
+ * 返回值：成功时返回可用的地址指针，否则返回NULL。
+ */
+void *DCMCalloc(DynamicCtnMan *dcm, size_t size)
+{
+    DCMBoundaryMarker *leftMarker;
+    uint8_t *pointer;
+    size_t holeSize;
+    char zeroed = 0;
+
+    CplLockAcquire(&dcm->lock);
+    pointer = DCMAllocInternal(dcm, size);
+    if (pointer) {
+        leftMarker = BASE_TO_LMARKER(LPOINTER_TO_BASE(pointer));
+        zeroed = leftMarker->zeroed;
+        leftMarker->zeroed = 0;
     }
-    return NULL;
+    DCMAudit(dcm);
+    CplLockRelease(&dcm->lock);
+    if (!pointer)
+        return NULL;
+
+    if (zeroed) {
+        holeSize = CHUNK_HOLE_SIZE(LPOINTER_TO_BASE(pointer));
+        memset(pointer, 0, CHUNK_POINT_SIZE);
+        memset(pointer + holeSize - CHUNK_POINT_SIZE - BOUNDARY_MARKER_SIZE, 0,
+               CHUNK_POINT_SIZE + BOUNDARY_MARKER_SIZE);
+    } else {
+        memset(pointer, 0, size);
+    }
+    return pointer;
 }
 
 /*
- * 功能：向管理器释放pointer指向的内存空间。
- * 返回值：无
+ * 功能：判断地址是否位于管理器的某个区域中，包括扩展堆区得到的区域。
+ * 返回值：是返回1，否则返回0。
  */
-void DCMFree(DynamicCtnMan *dcm, void *pointer)
+char DCMIsOwner(DynamicCtnMan *dcm, void *pointer)
+{
+    char owned;
+
+    CplLockAcquire(&dcm->lock);
+    owned = DCMFindRegion(dcm, pointer) != NULL;
+    CplLockRelease(&dcm->lock);
+    return owned;
+}
+
+/*
+ * 功能：获取pointer指向的内存空间的可用尺寸。
+ * 返回值：可用尺寸，pointer无效时返回0。
+ */
+size_t DCMUsableSize(DynamicCtnMan *dcm, void *pointer)
 {
     uint8_t *chunkBase;
-    DCMBoundaryMarker *leftMarker;
-    DCMBoundaryMarker *lNbRMarker, *rNbLMarker;
-    char lNbUsed = 1, rNbUsed = 1;
-    size_t freeChunkSize;
-    uint8_t *freeChunkBase;
 
     if (!pointer)
-        return;
-    /*根据待释放指针，获取被释放块的基地址和相邻块的使用信息。
-        如果相邻块是空闲的，则进行合并。*/
+        return 0;
     chunkBase = LPOINTER_TO_BASE(pointer);
-    if (!DCMChunkIsValid(dcm, chunkBase)) {
-        PrDbg("node [%p(H)] is invalide\n", chunkBase);
-        return;
-    }
+    if (!DCMUsedChunkIsValid(dcm, chunkBase))
+        return 0;
+    return CHUNK_HOLE_SIZE(chunkBase);
+}
 
-    leftMarker = BASE_TO_LMARKER(chunkBase);
-    lNbRMarker = CHUNK_LNB_RMARKER(chunkBase);
-    rNbLMarker = CHUNK_RNB_LMARKER(chunkBase);
+/*
+ * 功能：校验整个堆区的完整性，检查项见DCMVerifyInternal。
+ * 返回值：堆区完整返回0，否则返回-EFAULT。
+ */
+int DCMVerify(DynamicCtnMan *dcm)
+{
+    int ret;
 
-    /*判断相邻块是否有效且空闲。*/
-    if (DCMAddressIsValid(dcm, lNbRMarker)) {
-        if (DCMChunkIsFree(dcm, RMARKER_TO_BASE(lNbRMarker))) {
-            lNbUsed = 0;
-        }
-    }
-    if (DCMAddressIsValid(dcm, rNbLMarker)) {
-        if (DCMChunkIsFree(dcm, LMARKER_TO_BASE(rNbLMarker))) {
-            rNbUsed = 0;
+    if (!dcm)
+        return -EINVAL;
+    CplLockAcquire(&dcm->lock);
+    ret = DCMVerifyInternal(dcm);
+    CplLockRelease(&dcm->lock);
+    return ret;
+}
+
+/*
+ * 功能：设置完整性检查级别。切换是否使用真实校验和时，按照新级别重写所有空闲块的校验信息。
+ * level: DCM_CHECK_XXX
+ * auditPeriod: DCM_CHECK_AUDIT级别下的整堆校验周期，为0时使用DCM_AUDIT_DEFAULT_PERIOD。
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+int DCMSetCheckLevel(DynamicCtnMan *dcm, unsigned int level, unsigned int auditPeriod)
+{
+    uint8_t *chunkBase, *memEnd;
+    DCMBoundaryMarker *leftMarker;
+    unsigned int r;
+    char rewrite;
+
+    if (!dcm || level > DCM_CHECK_AUDIT)
+        return -EINVAL;
+
+    CplLockAcquire(&dcm->lock);
+    rewrite = (dcm->checkLevel >= DCM_CHECK_CHECKSUM) != (level >= DCM_CHECK_CHECKSUM);
+    dcm->checkLevel = level;
+    dcm->auditPeriod = auditPeriod ? auditPeriod : DCM_AUDIT_DEFAULT_PERIOD;
+    dcm->auditCount = 0;
+    for (r = 0; rewrite && r < dcm->regionCount; r++) {
+        memEnd = dcm->regions[r].base + dcm->regions[r].size;
+        for (chunkBase = dcm->regions[r].base; chunkBase < memEnd; chunkBase += leftMarker->chunkSize) {
+            leftMarker = BASE_TO_LMARKER(chunkBase);
+            /*遇到损坏的块时无法继续按物理地址遍历。*/
+            if (!DCMChunkSizeIsValid(dcm, chunkBase))
+                break;
+            if (leftMarker->used == 0) {
+                leftMarker->checksum = DCMChunkChecksum(dcm, chunkBase);
+                BASE_TO_RMARKER(chunkBase)->checksum = leftMarker->checksum;
+            }
         }
     }
+    CplLockRelease(&dcm->lock);
+    return 0;
+}
 
-    /*从管理器中删除有效相邻空闲块，并跟被释放块合并到一起添加到管理器中。*/
-    if (lNbUsed == 0 && rNbUsed == 0) {
-        freeChunkSize = lNbRMarker->chunkSize + leftMarker->chunkSize + rNbLMarker->chunkSize;
-        freeChunkBase = RMARKER_TO_BASE(lNbRMarker);
-        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, lNbRMarker->chunkSize), RMARKER_TO_BASE(lNbRMarker));
-        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, rNbLMarker->chunkSize), LMARKER_TO_BASE(rNbLMarker));
-    } else if (lNbUsed == 0) {
-        freeChunkSize = lNbRMarker->chunkSize + leftMarker->chunkSize;
-        freeChunkBase = RMARKER_TO_BASE(lNbRMarker);
-        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, lNbRMarker->chunkSize), RMARKER_TO_BASE(lNbRMarker));
-    } else if (rNbUsed == 0) {
-        freeChunkSize = leftMarker->chunkSize + rNbLMarker->chunkSize;
-        freeChunkBase = chunkBase;
-        DCMContainerDelChunk(dcm, DCMSelectChunkContainer(dcm, rNbLMarker->chunkSize), LMARKER_TO_BASE(rNbLMarker));
-    } else {
-        freeChunkBase = chunkBase;
-        freeChunkSize = leftMarker->chunkSize;
-    }
-    DCMAddChunk(dcm, freeChunkBase, freeChunkSize);
+/*
+ * 功能：向管理器添加一个区域，调用者持有管理器锁。区域末尾保留一个已使用的哨兵边界标记，
+ *      区域中第一个块的prevUsed为1，因此块的合并不会跨越区域。
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+static int DCMAddRegionInternal(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen, unsigned int flags)
+{
+    DCMRegion *region;
+    DCMBoundaryMarker *sentinel;
+    uint8_t *base;
+
+    if (!buffer || bufLen < MEM_MAN_ALIGN_SIZE)
+        return -EINVAL;
+    if (dcm->regionCount >= DCM_MAX_REGIONS)
+        return -ENOSPC;
+
+    /*基地址8字节对齐，可用内存尺寸对齐后向下取整MEM_MAN_ALIGN_SIZE大小。*/
+    base = CHUNK_ALIGN_ADDR(buffer);
+    bufLen -= CHUNK_ALIGN_OFFSET(buffer);
+    bufLen = CHUNK_SIZE_ROUND_DOWN(bufLen);
+    if (bufLen < CHUNK_MIN_SIZE + BOUNDARY_MARKER_SIZE)
+        return -EINVAL;
+    /*区域整体作为一个空闲块加入管理器，超出最大块尺寸的部分不使用。*/
+    if ((uint64_t)bufLen > CHUNK_MAX_SIZE + BOUNDARY_MARKER_SIZE)
+        bufLen = (size_t)(CHUNK_MAX_SIZE + BOUNDARY_MARKER_SIZE);
+
+    region = &dcm->regions[dcm->regionCount++];
+    region->base = base;
+    region->size = bufLen - BOUNDARY_MARKER_SIZE;
+    region->flags = flags;
+    sentinel = BASE_TO_LMARKER(base + region->size);
+    memset(sentinel, 0, BOUNDARY_MARKER_SIZE);
+    sentinel->used = 1;
+    sentinel->prevUsed = 1;
+    dcm->memSize += region->size;
+
+    /*把区域添加到管理器中，新区域整体成为顶块。*/
+    DCMSetTopEnd(dcm, region->base + region->size);
+    DCMAddChunk(dcm, region->base, region->size);
+    if (flags & DCM_FLAG_ZEROED)
+        BASE_TO_LMARKER(region->base)->zeroed = 1;
+    return 0;
 }
 
 /*
- * 功能：初始化一个动态容器管理器
- * dcm: 动态容器管理器
- * buffer: 动态容器管理器的内存
- * bufLen: 内存大小
+ * 功能：向管理器添加一个区域，用于扩展堆区。
+ * flags: DCM_FLAG_XXX
  * 返回值：成功时返回0，否则返回错误码。
  */
-int DCMInit(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen)
+int DCMAddRegion(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen, unsigned int flags)
 {
-    size_t i;
+    int ret;
 
     if (!dcm)
         return -EINVAL;
+    CplLockAcquire(&dcm->lock);
+    ret = DCMAddRegionInternal(dcm, buffer, bufLen, flags);
+    CplLockRelease(&dcm->lock);
+    return ret;
+}
+
+/*
+ * 功能：设置扩展堆区的回调函数，分配失败时调用回调获取新的区域。
+ * grow: 回调函数，为NULL时不自动扩展
+ * arg: 传给回调函数的参数
+ * flags: 回调返回的内存的DCM_FLAG_XXX
+ * 返回值：无
+ */
+void DCMSetGrowFunc(DynamicCtnMan *dcm, DCMGrowFunc grow, void *arg, unsigned int flags)
+{
+    CplLockAcquire(&dcm->lock);
+    dcm->grow = grow;
+    dcm->growArg = arg;
+    dcm->growFlags = flags;
+    CplLockRelease(&dcm->lock);
+}
+
+/*
+ * 功能：设置归还物理页的参数。
+ * minSize: 只归还不小于该尺寸的空闲块，为0时使用DCM_PURGE_DEFAULT_MIN_SIZE
+ * threshold: 释放的大块累计超过该尺寸时在DCMFree中自动归还，为0时只在调用DCMPurge时归还
+ * 返回值：无
+ */
+void DCMSetPurge(DynamicCtnMan *dcm, size_t minSize, size_t threshold)
+{
+    CplLockAcquire(&dcm->lock);
+    dcm->purgeMinSize = minSize ? minSize : DCM_PURGE_DEFAULT_MIN_SIZE;
+    dcm->purgeThreshold = threshold;
+    CplLockRelease(&dcm->lock);
+}
+
+/*
+ * 功能：把可归还区域（DCM_FLAG_PURGEABLE）中大空闲块占用的物理页还给系统。
+ * 返回值：归还的字节数
+ */
+size_t DCMPurge(DynamicCtnMan *dcm)
+{
+    size_t purged;
+
+    CplLockAcquire(&dcm->lock);
+    purged = DCMPurgeInternal(dcm);
+    CplLockRelease(&dcm->lock);
+    return purged;
+}
+
+/*
+ * 功能：基于mmap的堆区扩展回调，每次至少映射DCM_GROW_MIN_SIZE字节，返回的内存全为0且是匿名私有映射，
+ *      设置回调时可以使用DCM_FLAG_ZEROED | DCM_FLAG_PURGEABLE。
+ * 返回值：成功时返回映射的内存，否则返回NULL。
+ */
+void *DCMMmapGrow(void *arg, size_t minSize, size_t *pSize)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    void *p;
+
+    (void)arg;
+    if (minSize < DCM_GROW_MIN_SIZE)
+        minSize = DCM_GROW_MIN_SIZE;
+    minSize = (minSize + pageSize - 1) / pageSize * pageSize;
+    p = mmap(NULL, minSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    *pSize = minSize;
+    return p;
+#else
+    (void)arg;
+    (void)minSize;
+    (void)pSize;
+    return NULL;
+#endif
+}
+
+/*
+ * 功能：基于大页的堆区扩展回调，映射的尺寸按DCM_HUGE_PAGE_SIZE取整，以减少大堆区的TLB缺失。
+ *      优先使用MAP_HUGETLB（需要系统预留大页），失败时映射按DCM_HUGE_PAGE_SIZE对齐的普通内存
+ *      并通过MADV_HUGEPAGE建议内核使用透明大页。返回的内存全为0，设置回调时可以使用DCM_FLAG_ZEROED；
+ *      也可以直接调用该函数获取初始化管理器的内存。不建议对这些区域使用DCM_FLAG_PURGEABLE，
+ *      按普通页归还会拆分透明大页，大页映射则会归还失败。
+ * 返回值：成功时返回映射的内存，否则返回NULL。
+ */
+void *DCMHugePageGrow(void *arg, size_t minSize, size_t *pSize)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    uint8_t *p, *aligned;
+    size_t head;
+
+    (void)arg;
+    if (minSize < DCM_GROW_MIN_SIZE)
+        minSize = DCM_GROW_MIN_SIZE;
+    minSize = (minSize + DCM_HUGE_PAGE_SIZE - 1) / DCM_HUGE_PAGE_SIZE * DCM_HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+    p = mmap(NULL, minSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        *pSize = minSize;
+        return p;
+    }
+#endif
+    /*多映射一个大页，截去首尾使起始地址按大页对齐。*/
+    p = mmap(NULL, minSize + DCM_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    head = (DCM_HUGE_PAGE_SIZE - (size_t)p % DCM_HUGE_PAGE_SIZE) % DCM_HUGE_PAGE_SIZE;
+    aligned = p + head;
+    if (head)
+        munmap(p, head);
+    munmap(aligned + minSize, DCM_HUGE_PAGE_SIZE - head);
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, minSize, MADV_HUGEPAGE);
+#endif
+    *pSize = minSize;
+    return aligned;
+#else
+    (void)arg;
+    (void)minSize;
+    (void)pSize;
+    return NULL;
+#endif
+}
+
+/*
+ * 功能：把管理器中的容器、容器位图、元数据表项和顶块置为空。
+ * 返回值：无
+ */
+static void DCMClearContainers(DynamicCtnMan *dcm)
+{
+    size_t i;
 
-    dcm->memBase = NULL;
-    dcm->memSize = 0;
-    /*初始化管理器中的容器为空。*/
     for (i = 0; i < ARRAY_SIZE(dcm->containers); i++) {
         dcm->containers[i].prev = &dcm->containers[i];
         dcm->containers[i].next = &dcm->containers[i];
         dcm->containers[i].chunkCnt = 0;
+        dcm->containers[i].root = NULL;
     }
-    if (!buffer || bufLen < MEM_MAN_ALIGN_SIZE) {
-        return -EINVAL;
-    }
+#ifdef DCM_OOL_META
+    dcm->metaFree = NULL;
+#endif
+#ifdef DCM_TLSF
+    dcm->flBitmap = 0;
+    memset(dcm->slBitmap, 0, sizeof (dcm->slBitmap));
+#else
+    dcm->binBitmap = 0;
+#endif
+    dcm->top = NULL;
+    dcm->topEnd = NULL;
+}
 
-    /*基地址8字节对齐，可用内存尺寸对齐后向下取整MEM_MAN_ALIGN_SIZE大小。*/
-    dcm->memBase = CHUNK_ALIGN_ADDR(buffer);
-    bufLen -= CHUNK_ALIGN_OFFSET(buffer);
-    bufLen = CHUNK_SIZE_ROUND_DOWN(bufLen);
-    if (bufLen < CHUNK_MIN_SIZE)
+/*
+ * 功能：初始化一个动态容器管理器
+ * dcm: 动态容器管理器
+ * buffer: 动态容器管理器的内存
+ * bufLen: 内存大小
+ * flags: DCM_FLAG_XXX
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+int DCMInitWithFlags(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen, unsigned int flags)
+{
+    if (!dcm)
         return -EINVAL;
-    dcm->memSize = bufLen;
 
-    /*把被管理的内存添加到管理器中。*/
-    DCMAddChunk(dcm, dcm->memBase, dcm->memSize);
-    return 0;
+    dcm->regionCount = 0;
+    dcm->memSize = 0;
+    dcm->grow = NULL;
+    dcm->growArg = NULL;
+    dcm->growFlags = 0;
+    dcm->purgeMinSize = DCM_PURGE_DEFAULT_MIN_SIZE;
+    dcm->purgeThreshold = 0;
+    dcm->purgeDirty = 0;
+    dcm->checkLevel = DCM_DEFAULT_CHECK_LEVEL;
+    dcm->auditPeriod = DCM_AUDIT_DEFAULT_PERIOD;
+    dcm->auditCount = 0;
+    CplLockInit(&dcm->lock);
+    DCMClearContainers(dcm);
+    return DCMAddRegionInternal(dcm, buffer, bufLen, flags);
+}
+
+/*
+ * 功能：初始化一个动态容器管理器
+ * dcm: 动态容器管理器
+ * buffer: 动态容器管理器的内存
+ * bufLen: 内存大小
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+int DCMInit(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen)
+{
+    return DCMInitWithFlags(dcm, buffer, bufLen, 0);
+}
+
+/*
+ * 功能：释放管理器中的所有块，不遍历块：清空容器后每个区域重新成为一个空闲块，最后一个区域成为顶块。
+ *      保留所有区域（包括扩展得到的区域）和管理器配置，块的清零状态被清除。
+ * 返回值：无
+ */
+void DCMReset(DynamicCtnMan *dcm)
+{
+    DCMRegion *region;
+    unsigned int r;
+
+    CplLockAcquire(&dcm->lock);
+    DCMClearContainers(dcm);
+    dcm->purgeDirty = 0;
+    dcm->auditCount = 0;
+    for (r = 0; r < dcm->regionCount; r++) {
+        region = &dcm->regions[r];
+        DCMSetTopEnd(dcm, region->base + region->size);
+        DCMAddChunk(dcm, region->base, region->size);
+    }
+    CplLockRelease(&dcm->lock);
 }
 
 /*
@@ -694,8 +2486,7 @@ static void DCMContainerPrint(DynamicCtnMan *dcm, DCMContainer *container, size_
     lastNode = CONTAINER_NODE(container);
     iterNode = container->next;
     for ( ;iterNode != CONTAINER_NODE(container); ) {
-        chunkBase = NODE_TO_CHUNK(iterNode);
-        if (!DCMChunkIsFree(dcm, chunkBase)) {
+        if (!DCMNodeIsFree(dcm, iterNode)) {
             iterNode = DCMSearchNextValidNode(dcm, container, lastNode);
             if (iterNode == CONTAINER_NODE(container)
                     || iterNode == lastNode) {
@@ -705,12 +2496,12 @@ static void DCMContainerPrint(DynamicCtnMan *dcm, DCMContainer *container, size_
         chunkCount++;
         chunkBase = NODE_TO_CHUNK(iterNode);
         lastNode = iterNode;
-        printf("chunck%u size: %u byte\n", i++, BASE_TO_LMARKER(chunkBase)->chunkSize);
+        printf("chunck%zu size: %zu byte\n", i++, (size_t)BASE_TO_LMARKER(chunkBase)->chunkSize);
         *pFreeSize += BASE_TO_LMARKER(chunkBase)->chunkSize;
-        iterNode = CHUNK_GET_NEXT_NODE(chunkBase);
+        iterNode = NODE_GET_NEXT(iterNode);
     }
     printf("chunk count: %u\n", container->chunkCnt);
-    printf("valid chunk count: %u\n", chunkCount);
+    printf("valid chunk count: %zu\n", chunkCount);
 
     return;
 }
@@ -729,14 +2520,19 @@ void DCMPrint(DynamicCtnMan *dcm)
     for (i = 0; i < ARRAY_SIZE(dcm->containers); i++) {
         if (DCMContainerIsEmpty(&dcm->containers[i]))
             continue;
-        printf("container [%p(H)] %u:\n", &dcm->containers[i], i);
+        printf("container [%p(H)] %zu:\n", &dcm->containers[i], i);
         DCMContainerPrint(dcm, &dcm->containers[i], &freeSize);
         printf("-------------------------------------------\n");
     }
-    printf("memory sapce base: %p(H)\n", dcm->memBase);
-    printf("total memory sapce %u byte\n", dcm->memSize);
-    printf("free memory space %u byte\n", freeSize);
-    printf("used memory space %u byte\n", dcm->memSize - freeSize);
+    if (dcm->top) {
+        printf("top chunk [%p(H)] size: %zu byte\n", dcm->top, (size_t)BASE_TO_LMARKER(dcm->top)->chunkSize);
+        freeSize += BASE_TO_LMARKER(dcm->top)->chunkSize;
+    }
+    for (i = 0; i < dcm->regionCount; i++)
+        printf("region %zu: %p(H) %zu byte\n", i, dcm->regions[i].base, dcm->regions[i].size);
+    printf("total memory sapce %zu byte\n", dcm->memSize);
+    printf("free memory space %zu byte\n", freeSize);
+    printf("used memory space %zu byte\n", dcm->memSize - freeSize);
     printf("----------------------END----------------------\n");
 }
 
@@ -756,3 +2552,107 @@ void DCMExample(void)
 
 }
 
+
+/*
+ * 功能：测量各完整性检查级别下随机分配和释放的平均耗时。
+ * 返回值：无
+ */
+void DCMBenchmark(void)
+{
+    static uint8_t buf[1024 * 1024];
+    static void *addr[1024];
+    const char *names[] = {"none", "marker", "checksum", "audit"};
+    DynamicCtnMan dcmx, *dcm = &dcmx;
+    const unsigned int rounds = 200000;
+    unsigned int level, r, i;
+    clock_t start;
+    double ns;
+
+    printf("level     alloc+free(ns)\n");
+    for (level = DCM_CHECK_NONE; level <= DCM_CHECK_AUDIT; level++) {
+        DCMInit(dcm, buf, sizeof (buf));
+        DCMSetCheckLevel(dcm, level, 0);
+        memset(addr, 0, sizeof (addr));
+        srand(1);
+        start = clock();
+        for (r = 0; r < rounds; r++) {
+            i = rand() % (ARRAY_SIZE(addr));
+            if (addr[i]) {
+                DCMFree(dcm, addr[i]);
+                addr[i] = NULL;
+            } else {
+                addr[i] = DCMAlloc(dcm, 1 + rand() % 512);
+            }
+        }
+        ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / rounds;
+        printf("%-8s  %14.1f\n", names[level], ns);
+    }
+}
+
+/*
+ * 功能：按物理地址顺序统计空闲块的总尺寸和最大空闲块的尺寸。
+ * 返回值：无
+ */
+static void DCMFreeStat(DynamicCtnMan *dcm, size_t *pFreeSize, size_t *pLargest)
+{
+    uint8_t *chunkBase, *memEnd;
+    DCMBoundaryMarker *leftMarker;
+    unsigned int r;
+
+    *pFreeSize = *pLargest = 0;
+    CplLockAcquire(&dcm->lock);
+    for (r = 0; r < dcm->regionCount; r++) {
+        memEnd = dcm->regions[r].base + dcm->regions[r].size;
+        for (chunkBase = dcm->regions[r].base; chunkBase < memEnd; chunkBase += leftMarker->chunkSize) {
+            leftMarker = BASE_TO_LMARKER(chunkBase);
+            if (!DCMChunkSizeIsValid(dcm, chunkBase))
+                break;
+            if (leftMarker->used)
+                continue;
+            *pFreeSize += leftMarker->chunkSize;
+            if (leftMarker->chunkSize > *pLargest)
+                *pLargest = leftMarker->chunkSize;
+        }
+    }
+    CplLockRelease(&dcm->lock);
+}
+
+/*
+ * 功能：长时间随机分配和释放尺寸跨度很大的内存，周期性地输出空闲内存、最大空闲块尺寸和碎片率
+ *      （1 - 最大空闲块尺寸 / 空闲内存），用于观察堆区的碎片化程度。
+ * 返回值：无
+ */
+void DCMFragBenchmark(void)
+{
+    static uint8_t buf[32 * 1024 * 1024];
+    static void *addr[2048];
+    DynamicCtnMan dcmx, *dcm = &dcmx;
+    const unsigned int rounds = 2000000, period = 200000;
+    unsigned int r, i, failed = 0;
+    size_t size, freeSize, largest;
+
+    DCMInit(dcm, buf, sizeof (buf));
+    memset(addr, 0, sizeof (addr));
+    srand(1);
+    printf("round     free(KiB)  largest(KiB)  frag(%%)  failed\n");
+    for (r = 1; r <= rounds; r++) {
+        i = rand() % (ARRAY_SIZE(addr));
+        if (addr[i]) {
+            DCMFree(dcm, addr[i]);
+            addr[i] = NULL;
+        } else {
+            /*尺寸在16字节到128KiB之间按对数均匀分布。*/
+            size = (size_t)16 << (rand() % 13);
+            size += rand() % size;
+            addr[i] = DCMAlloc(dcm, size);
+            failed += !addr[i];
+        }
+        if (r % period == 0) {
+            DCMFreeStat(dcm, &freeSize, &largest);
+            printf("%-8u  %9zu  %12zu  %7.2f  %6u\n", r, freeSize / 1024, largest / 1024,
+                   freeSize ? 100.0 * (freeSize - largest) / freeSize : 0.0, failed);
+        }
+    }
+    for (i = 0; i < ARRAY_SIZE(addr); i++)
+        DCMFree(dcm, addr[i]);
+}
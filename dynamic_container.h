@@ -6,26 +6,134 @@ extern "C" {
 #endif
 
 #include "stdint.h"
+#include "stddef.h"
+#include "cpl_lock.h"
 
 /*动态内存管理容器。*/
 typedef struct _DCMContainer {
     unsigned int chunkCnt;      /*容器中的块数量*/
     void *prev;
     void *next;
+    void *root;                 /*树容器中按位字典树的根节点，其他容器中不使用*/
 } DCMContainer;
 
+/*块尺寸的有效位数，单个块（以及单个区域）最大为pow(2, DCM_SIZE_BITS)字节。*/
+#define DCM_SIZE_BITS           45
+
+/*定义后使用两级分离适配（TLSF）方式组织容器：一级按窗口尺寸以2为底的对数分级，
+    每一级再线性划分为DCM_SL_COUNT个子容器，并用一级和二级位图记录非空容器，
+    分配和释放的时间复杂度为O(1)。*/
+//#define DCM_TLSF
+
+#ifdef DCM_TLSF
+/*二级子容器数量以2为底的对数*/
+#define DCM_SL_LOG2             3
+#define DCM_SL_COUNT            (1 << DCM_SL_LOG2)
+/*窗口尺寸小于DCM_SMALL_SIZE的块全部位于一级容器0中，按MEM_MAN_ALIGN_SIZE线性划分。*/
+#define DCM_FL_SHIFT            (DCM_SL_LOG2 + 3)
+#define DCM_SMALL_SIZE          (1 << DCM_FL_SHIFT)
+/*一级容器数量*/
+#define DCM_FL_COUNT            (DCM_SIZE_BITS - DCM_FL_SHIFT + 1)
+#define DCM_CONTAINER_COUNT     (DCM_FL_COUNT * DCM_SL_COUNT)
+#else
+#define DCM_CONTAINER_COUNT     DCM_SIZE_BITS
+/*定义后窗口尺寸不小于pow(2, DCM_TREE_MIN_LOG2)的容器（树容器）另外按窗口尺寸把空闲块组织为按位字典树，
+    分配时在树中查找最佳适配的块，时间复杂度为O(log n)，避免首次适配拆分大块造成碎片。*/
+#define DCM_TREE
+#define DCM_TREE_MIN_LOG2       8
+#endif
+
+/*定义后空闲块的链表指针、尺寸和树节点保存在堆区中的元数据页里，块内只保留左边界标记后的表项指针。
+    查找空闲块时只访问元数据，不访问块末尾的右边界标记和节点指针，减少对冷内存的访问。*/
+//#define DCM_OOL_META
+/*元数据表项耗尽时每次从堆区分配的元数据页尺寸*/
+#define DCM_META_PAGE_SIZE      4096
+
+/*完整性检查级别*/
+#define DCM_CHECK_NONE          0   /*不检查，链表中的块直接视为有效空闲块，仅读取使用标志判断相邻块能否合并*/
+#define DCM_CHECK_MARKER        1   /*检查左右边界标记是否一致*/
+#define DCM_CHECK_CHECKSUM      2   /*检查边界标记并校验空闲块数据区的校验和*/
+#define DCM_CHECK_AUDIT         3   /*同DCM_CHECK_CHECKSUM，并每隔auditPeriod次操作校验整个堆区*/
+
+/*DCM_CHECK_AUDIT级别下默认的整堆校验周期（分配和释放次数）*/
+#define DCM_AUDIT_DEFAULT_PERIOD    1024
+
+/*初始化标志：管理的内存初始全为0，例如刚从mmap获得的内存，DCMCalloc分配这部分内存时无需清零。*/
+#define DCM_FLAG_ZEROED         0x1
+/*区域标志：区域是匿名私有映射（例如DCMMmapGrow返回的内存），可以通过madvise把空闲块占用的物理页还给系统。*/
+#define DCM_FLAG_PURGEABLE      0x2
+
+/*区域数量上限*/
+#define DCM_MAX_REGIONS         32
+/*自动扩展堆区时单次申请的最小尺寸*/
+#define DCM_GROW_MIN_SIZE       (1024 * 1024)
+/*DCMHugePageGrow映射的内存按该尺寸对齐和取整*/
+#define DCM_HUGE_PAGE_SIZE      (2 * 1024 * 1024)
+/*默认只归还不小于该尺寸的空闲块的物理页*/
+#define DCM_PURGE_DEFAULT_MIN_SIZE  (64 * 1024)
+
+/*堆区中的一段连续内存，末尾保留一个已使用的哨兵边界标记，块的合并不会跨越区域。*/
+typedef struct {
+    uint8_t *base;                  /*区域中第一个块的地址*/
+    size_t size;                    /*区域中块占用的尺寸，不含末尾的哨兵*/
+    unsigned int flags;             /*DCM_FLAG_XXX*/
+} DCMRegion;
+
+/*扩展堆区的回调函数，返回至少minSize字节的内存并通过pSize返回实际尺寸，失败时返回NULL。*/
+typedef void *(*DCMGrowFunc)(void *arg, size_t minSize, size_t *pSize);
+
 /* 动态内存管理数据结构。
- * 共包含32个动态容器，从容器3开始，每个容器管理一部分块。例如：容器3中管理(0-8]大小的块，
+ * 默认共包含DCM_SIZE_BITS个动态容器，从容器3开始，每个容器管理一部分块。例如：容器3中管理(0-8]大小的块，
  * 容器4管理(8-16]大小的块，容器5管理(16-32]大小的块，以此类推。*/
 typedef struct {
-    DCMContainer containers[32];    /*容器数组*/
-    uint8_t *memBase;               /*动态内存管理堆区的基地址。*/
-    unsigned int memSize;           /*动态内存管理堆区大小。*/
+    DCMContainer containers[DCM_CONTAINER_COUNT];   /*容器数组*/
+#ifdef DCM_TLSF
+    uint64_t flBitmap;                  /*一级位图，比特位为1表示该级中有非空的子容器*/
+    uint32_t slBitmap[DCM_FL_COUNT];    /*二级位图，比特位为1表示对应的子容器非空*/
+#else
+    uint64_t binBitmap;                 /*容器位图，比特位为1表示对应的容器非空*/
+#endif
+    uint8_t *top;                       /*顶块：最后添加的区域末尾的空闲块，不放入容器，容器中没有合适的块时从头部切分分配，为NULL时没有顶块*/
+    uint8_t *topEnd;                    /*顶块所在区域的末尾（哨兵地址），结束于此的空闲块即为顶块*/
+    DCMRegion regions[DCM_MAX_REGIONS]; /*组成堆区的区域*/
+    unsigned int regionCount;       /*有效区域数量*/
+    size_t memSize;                 /*动态内存管理堆区大小，所有区域的总和。*/
+    DCMGrowFunc grow;               /*扩展堆区的回调函数，为NULL时不自动扩展*/
+    void *growArg;                  /*传给扩展回调的参数*/
+    unsigned int growFlags;         /*扩展回调返回的内存的DCM_FLAG_XXX*/
+    size_t purgeMinSize;            /*只归还不小于该尺寸的空闲块的物理页*/
+    size_t purgeThreshold;          /*释放的大块累计超过该尺寸时自动归还物理页，为0时不自动归还*/
+    size_t purgeDirty;              /*上次归还后释放的大块累计尺寸*/
+    uint8_t checkLevel;             /*完整性检查级别，DCM_CHECK_XXX*/
+    unsigned int auditPeriod;       /*整堆校验周期*/
+    unsigned int auditCount;        /*距上次整堆校验的操作次数*/
+#ifdef DCM_OOL_META
+    void *metaFree;                 /*空闲的元数据表项链表*/
+#endif
+    CplLock lock;                   /*管理器锁。释放时需要合并相邻块，相邻块可能位于任意容器中，
+                                        因此整个堆区共用一把锁。*/
 } DynamicCtnMan;
 
 int DCMInit(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen);
+int DCMInitWithFlags(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen, unsigned int flags);
 void *DCMAlloc(DynamicCtnMan *dcm, size_t size);
+void *DCMCalloc(DynamicCtnMan *dcm, size_t size);
+unsigned int DCMAllocBatch(DynamicCtnMan *dcm, size_t size, void **out, unsigned int n);
 void DCMFree(DynamicCtnMan *dcm, void *pointer);
+void DCMFreeBatch(DynamicCtnMan *dcm, void * const *ptrs, unsigned int n);
+void DCMReset(DynamicCtnMan *dcm);
+int DCMAddRegion(DynamicCtnMan *dcm, uint8_t *buffer, size_t bufLen, unsigned int flags);
+void DCMSetGrowFunc(DynamicCtnMan *dcm, DCMGrowFunc grow, void *arg, unsigned int flags);
+void *DCMMmapGrow(void *arg, size_t minSize, size_t *pSize);
+void *DCMHugePageGrow(void *arg, size_t minSize, size_t *pSize);
+void DCMSetPurge(DynamicCtnMan *dcm, size_t minSize, size_t threshold);
+size_t DCMPurge(DynamicCtnMan *dcm);
+void *DCMRealloc(DynamicCtnMan *dcm, void *pointer, size_t size);
+void *DCMAllocAligned(DynamicCtnMan *dcm, size_t size, size_t align);
+size_t DCMUsableSize(DynamicCtnMan *dcm, void *pointer);
+char DCMIsOwner(DynamicCtnMan *dcm, void *pointer);
+int DCMSetCheckLevel(DynamicCtnMan *dcm, unsigned int level, unsigned int auditPeriod);
+int DCMVerify(DynamicCtnMan *dcm);
 
 void DCMPrint(DynamicCtnMan *dcm);
 
@@ -6,11 +6,20 @@
  **/
 #include "linear_container.h"
 #include "mem_man.h"
+#include "cpl_bitops.h"
 #include "stdint.h"
 #include "stdio.h"
 #include "errno.h"
 #include "string.h"
 #include "math.h"
+#include "time.h"
+#include "stdlib.h"
+
+//#define LCM_SIMD_SCAN
+
+#if defined(LCM_SIMD_SCAN) && (defined(__AVX2__) || defined(__SSE2__))
+#include "immintrin.h"
+#endif
 
 /*块地址对齐MEM_MAN_ALIGN_SIZE后的偏移量*/
 #define CHUNK_ALIGN_OFFSET(chunk_addr)                  ((MEM_MAN_ALIGN_SIZE - ((size_t)chunk_addr % MEM_MAN_ALIGN_SIZE)) % MEM_MAN_ALIGN_SIZE)
@@ -19,6 +28,15 @@
 
 #define META_GAP_SIZE           32
 
+/*元数据字长度及每个字包含的比特位数*/
+#define META_WORD_SIZE          (sizeof (uint64_t))
+#define META_WORD_BITS          64
+/*元数据字全部为已使用状态*/
+#define META_WORD_FULL          (~(uint64_t)0)
+
+/*地址按META_WORD_SIZE对齐后的地址*/
+#define META_ALIGN_ADDR(addr)   ((uint8_t *)(addr) + (META_WORD_SIZE - ((size_t)(addr) % META_WORD_SIZE)) % META_WORD_SIZE)
+
 /*内存单元状态*/
 #define UNIT_STATE_FREE         0   /*空闲*/
 #define UNIT_STATE_USED         1   /*已被分配*/
@@ -29,12 +47,12 @@
  */
 static void LCMMetaSetBit(LCMCtnMeta *meta, unsigned int pos, char val)
 {
-    unsigned int a = pos / 8, b = pos % 8;
+    unsigned int a = pos / META_WORD_BITS, b = pos % META_WORD_BITS;
 
     if (val) {
-        meta->base[a] |= 1 << b;
+        meta->base[a] |= (uint64_t)1 << b;
     } else {
-        meta->base[a] &= ~(1 << b);
+        meta->base[a] &= ~((uint64_t)1 << b);
     }
 }
 
@@ -44,9 +62,35 @@ static void LCMMetaSetBit(LCMCtnMeta *meta, unsigned int pos, char val)
  */
 static char LCMMetaGetBit(LCMCtnMeta *meta, unsigned int pos)
 {
-    unsigned int a = pos / 8, b = pos % 8;
+    unsigned int a = pos / META_WORD_BITS, b = pos % META_WORD_BITS;
 
-    return meta->base[a] & (1 << b);
+    return (meta->base[a] >> b) & 1;
+}
+
+/*
+ * 功能：元数据区第word个字的空闲状态发生变化后，逐层更新摘要位图。
+ * hasFree: 该字中是否还有空闲单元
+ * 返回值：无。
+ */
+static void LCMSummaryUpdate(LCMLinearContainer *container, unsigned int word, char hasFree)
+{
+    unsigned int lvl;
+    uint64_t *s, old;
+
+    for (lvl = 0; lvl < container->summaryLevels; lvl++) {
+        s = &container->summary[lvl][word / META_WORD_BITS];
+        old = *s;
+        if (hasFree) {
+            *s |= (uint64_t)1 << (word % META_WORD_BITS);
+        } else {
+            *s &= ~((uint64_t)1 << (word % META_WORD_BITS));
+        }
+        /*本层字是否为0没有变化时，上层摘要不受影响。*/
+        if ((old != 0) == (*s != 0))
+            break;
+        hasFree = (*s != 0);
+        word /= META_WORD_BITS;
+    }
 }
 
 /*
@@ -55,8 +99,12 @@ static char LCMMetaGetBit(LCMCtnMeta *meta, unsigned int pos)
  */
 static void LCMContainerSetUnitState(LCMLinearContainer *container, unsigned int pos, char val)
 {
+    unsigned int word = pos / META_WORD_BITS;
+
     LCMMetaSetBit(&container->metas[0], pos, val);
     LCMMetaSetBit(&container->metas[1], pos, val);
+    LCMSummaryUpdate(container, word,
+                     (container->metas[0].base[word] | container->metas[1].base[word]) != META_WORD_FULL);
 }
 
 /*
@@ -72,6 +120,53 @@ static char LCDContainerGetUnitState(LCMLinearContainer *container, unsigned int
         return UNIT_STATE_USED;
 }
 
+/*
+ * 功能：根据元数据区计算摘要位图每层的字数量和层数。
+ * 返回值：摘要位图的总字数，内存单元数量超出摘要位图的表示范围时返回0。
+ */
+static size_t LCMSummaryLayout(size_t metaWords, unsigned int *pLevels)
+{
+    size_t words = metaWords, total = 0;
+    unsigned int lvl = 0;
+
+    do {
+        if (lvl == LCM_SUMMARY_LEVELS)
+            return 0;
+        words = (words + META_WORD_BITS - 1) / META_WORD_BITS;
+        total += words;
+        lvl++;
+    } while (words > 1);
+    *pLevels = lvl;
+    return total;
+}
+
+/*
+ * 功能：根据两个元数据区重建摘要位图和空闲单元计数。
+ *      元数据区是内存单元状态的唯一依据，摘要与之不一致时以元数据区为准。
+ * 返回值：无。
+ */
+static void LCMContainerRebuildSummary(LCMLinearContainer *container)
+{
+    size_t words = container->metas[0].size / META_WORD_SIZE;
+    unsigned int lvl;
+    size_t w;
+    uint64_t freeBits;
+
+    container->freeCount = 0;
+    for (lvl = 0; lvl < container->summaryLevels; lvl++) {
+        memset(container->summary[lvl], 0, (words + META_WORD_BITS - 1) / META_WORD_BITS * META_WORD_SIZE);
+        words = (words + META_WORD_BITS - 1) / META_WORD_BITS;
+    }
+    words = container->metas[0].size / META_WORD_SIZE;
+    for (w = 0; w < words; w++) {
+        freeBits = ~(container->metas[0].base[w] | container->metas[1].base[w]);
+        if (freeBits) {
+            container->freeCount += CplPopcount64(freeBits);
+            LCMSummaryUpdate(container, w, 1);
+        }
+    }
+}
+
 /*
  * 功能：线性容器初始化
  * container：线性容器
@@ -84,10 +179,13 @@ static void LCMContainerInit(LCMLinearContainer *container, uint8_t *buf, size_t
 {
     size_t maxUnitCount;    /*buf能够初始化的最大内存单元数量*/
     size_t allocMetaSize;   /*分配给元数据区的尺寸*/
+    size_t summaryWords;    /*摘要位图的字数量*/
+    uint64_t *summary;
+    unsigned int lvl;
     uint8_t *endAddr;
     size_t temp;
 
-    if (!buf || !pRemain || bufSize < META_GAP_SIZE * 4 + MEM_MAN_ALIGN_SIZE
+    if (!buf || !pRemain || bufSize < META_GAP_SIZE * 4 + container->unitAlign
             || container->unitCount == 0
             || container->unitSize == 0
             || container->unitSize % 8 != 0) {
@@ -96,54 +194,266 @@ static void LCMContainerInit(LCMLinearContainer *container, uint8_t *buf, size_t
 
     temp = bufSize;
     temp -= META_GAP_SIZE * 4;
-    temp -= MEM_MAN_ALIGN_SIZE;
-    maxUnitCount = temp * 8 / (container->unitSize * 8 + 2);
+    temp -= container->unitAlign;
+    /*预留两个元数据区的字对齐、按字取整以及各层摘要位图按字取整的余量。*/
+    if (temp <= META_WORD_SIZE * (4 + LCM_SUMMARY_LEVELS))
+        goto err0;
+    temp -= META_WORD_SIZE * (4 + LCM_SUMMARY_LEVELS);
+    /*每个内存单元占用两个元数据位，摘要位图平均占用不到2/64位。*/
+    maxUnitCount = temp * 8 * META_WORD_BITS / ((container->unitSize * 8 + 2) * META_WORD_BITS + 2);
     if (maxUnitCount == 0)
         goto err0;
 
     if (maxUnitCount < container->unitCount) {
         container->unitCount = maxUnitCount;
     }
-    allocMetaSize = (container->unitCount + 7) / 8;
+    allocMetaSize = (container->unitCount + META_WORD_BITS - 1) / META_WORD_BITS * META_WORD_SIZE;
+    summaryWords = LCMSummaryLayout(allocMetaSize / META_WORD_SIZE, &container->summaryLevels);
+    if (summaryWords == 0)
+        goto err0;
 
-    container->metas[0].base = buf + META_GAP_SIZE;
-    container->base = container->metas[0].base + allocMetaSize + META_GAP_SIZE;
-    /*容器基地址MEM_MAN_ALIGN_SIZE对齐。*/
-    container->base = CHUNK_ALIGN_ADDR(container->base);
-    container->metas[1].base = container->base + container->unitCount * container->unitSize + META_GAP_SIZE;
-    endAddr = container->metas[1].base + allocMetaSize + META_GAP_SIZE;
+    /*摘要位图紧跟在元数据区0之后。*/
+    container->metas[0].base = (uint64_t *)META_ALIGN_ADDR(buf + META_GAP_SIZE);
+    summary = container->metas[0].base + allocMetaSize / META_WORD_SIZE;
+    temp = allocMetaSize / META_WORD_SIZE;
+    for (lvl = 0; lvl < LCM_SUMMARY_LEVELS; lvl++) {
+        temp = (temp + META_WORD_BITS - 1) / META_WORD_BITS;
+        container->summary[lvl] = lvl < container->summaryLevels ? summary : NULL;
+        if (lvl < container->summaryLevels)
+            summary += temp;
+    }
+    container->base = (uint8_t *)summary + META_GAP_SIZE;
+    /*容器基地址按unitAlign对齐，unitAlign整除unitSize，因此所有内存单元都按unitAlign对齐。*/
+    container->base += (container->unitAlign - (size_t)container->base % container->unitAlign) % container->unitAlign;
+    container->metas[1].base = (uint64_t *)META_ALIGN_ADDR(container->base + (size_t)container->unitCount * container->unitSize + META_GAP_SIZE);
+    endAddr = (uint8_t *)container->metas[1].base + allocMetaSize + META_GAP_SIZE;
     *pRemain = bufSize - (endAddr - buf);
 
     container->metas[0].size = allocMetaSize;
     container->metas[1].size = allocMetaSize;
     memset(container->metas[0].base, 0, allocMetaSize);
     memset(container->metas[1].base, 0, allocMetaSize);
+    /*最后一个字中超出内存单元数量的比特位置为已使用，查找空闲单元时无需判断边界。*/
+    if (container->unitCount % META_WORD_BITS) {
+        uint64_t padding = META_WORD_FULL << (container->unitCount % META_WORD_BITS);
+
+        container->metas[0].base[allocMetaSize / META_WORD_SIZE - 1] = padding;
+        container->metas[1].base[allocMetaSize / META_WORD_SIZE - 1] = padding;
+    }
+    LCMContainerRebuildSummary(container);
+    container->freeList = NULL;
+    container->nextUnitId = 0;
+    container->cleanUnitId = 0;
+    container->dirtyUnitId = 0;
     return;
 
 err0:
     container->unitCount = 0;
+    container->freeCount = 0;
+    container->summaryLevels = 0;
+    container->freeList = NULL;
+    container->nextUnitId = 0;
+    container->cleanUnitId = 0;
+    container->dirtyUnitId = 0;
     container->metas[0].size = 0;
     container->metas[1].size = 0;
     return;
 }
 
 /*
- * 功能：获取一个容器中空闲内存单元的id
+ * 功能：把容器恢复为所有内存单元空闲的状态。编号不小于dirtyUnitId的单元在上次重置后没有被分配过，
+ *      其元数据位和摘要位保持空闲状态，因此只清除dirtyUnitId之前的元数据字，
+ *      开销与上次重置后使用过的单元数量成正比，与容器尺寸无关。cleanUnitId保持不变，
+ *      之前被分配过的单元不再视为从未使用。
+ * 返回值：无。
+ */
+static void LCMContainerReset(LCMLinearContainer *container)
+{
+    unsigned int words, wordCount, w;
+
+    if (container->unitCount == 0)
+        return;
+    CplLockAcquire(&container->lock);
+    wordCount = container->metas[0].size / META_WORD_SIZE;
+    words = (container->dirtyUnitId + META_WORD_BITS - 1) / META_WORD_BITS;
+    memset(container->metas[0].base, 0, (size_t)words * META_WORD_SIZE);
+    memset(container->metas[1].base, 0, (size_t)words * META_WORD_SIZE);
+    if (words == wordCount && container->unitCount % META_WORD_BITS) {
+        uint64_t padding = META_WORD_FULL << (container->unitCount % META_WORD_BITS);
+
+        container->metas[0].base[wordCount - 1] = padding;
+        container->metas[1].base[wordCount - 1] = padding;
+    }
+    for (w = 0; w < words && container->summaryLevels; w++)
+        LCMSummaryUpdate(container, w, 1);
+    container->freeCount = container->unitCount;
+    container->freeList = NULL;
+    container->nextUnitId = 0;
+    container->dirtyUnitId = 0;
+    CplLockRelease(&container->lock);
+}
+
+/*
+ * 功能：顺序扫描元数据区，获取一个容器中空闲内存单元的id
  * 返回值：成功时返回0，否则返回错误码。
  */
-static int LCMContainerGetFreeUnitId(LCMLinearContainer *container, unsigned int *pUintId)
+static int LCMContainerScanFreeUnitId(LCMLinearContainer *container, unsigned int *pUintId)
 {
-    unsigned int c;
+    const uint64_t *m0 = container->metas[0].base;
+    const uint64_t *m1 = container->metas[1].base;
+    unsigned int wordCount = container->metas[0].size / META_WORD_SIZE;
+    unsigned int w = 0;
+    uint64_t freeBits;
+
+#if defined(LCM_SIMD_SCAN) && defined(__AVX2__)
+    /*每次检查256个比特位，跳过全部被使用的区域。*/
+    const __m256i full = _mm256_set1_epi64x(-1);
 
-    for (c = 0; c < container->unitCount; c++) {
-        if (UNIT_STATE_FREE == LCDContainerGetUnitState(container, c)) {
-            *pUintId = c;
+    for (; w + 4 <= wordCount; w += 4) {
+        __m256i used = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)&m0[w]),
+                                       _mm256_loadu_si256((const __m256i *)&m1[w]));
+        if (!_mm256_testc_si256(used, full))
+            break;
+    }
+#elif defined(LCM_SIMD_SCAN) && defined(__SSE2__)
+    /*每次检查256个比特位，跳过全部被使用的区域。*/
+    const __m128i full = _mm_set1_epi32(-1);
+
+    for (; w + 4 <= wordCount; w += 4) {
+        __m128i lo = _mm_or_si128(_mm_loadu_si128((const __m128i *)&m0[w]),
+                                  _mm_loadu_si128((const __m128i *)&m1[w]));
+        __m128i hi = _mm_or_si128(_mm_loadu_si128((const __m128i *)&m0[w + 2]),
+                                  _mm_loadu_si128((const __m128i *)&m1[w + 2]));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(lo, hi), full)) != 0xFFFF)
+            break;
+    }
+#endif
+
+    /*两个元数据区的对应位都为空闲时才认为是空闲，按64位字查找第一个空闲位。*/
+    for (; w < wordCount; w++) {
+        freeBits = ~(m0[w] | m1[w]);
+        if (freeBits) {
+            *pUintId = w * META_WORD_BITS + CplCtz64(freeBits);
             return 0;
         }
     }
     return -ENOMEM;
 }
 
+/*
+ * 功能：沿摘要位图逐层向下查找，获取一个容器中空闲内存单元的id
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+static int LCMContainerGetFreeUnitId(LCMLinearContainer *container, unsigned int *pUintId)
+{
+    unsigned int word = 0;
+    int lvl;
+    uint64_t bits;
+
+    if (container->freeCount == 0)
+        return -ENOMEM;
+    for (lvl = (int)container->summaryLevels - 1; lvl >= 0; lvl--) {
+        bits = container->summary[lvl][word];
+        if (!bits)
+            goto rebuild;
+        word = word * META_WORD_BITS + CplCtz64(bits);
+    }
+    bits = ~(container->metas[0].base[word] | container->metas[1].base[word]);
+    if (!bits)
+        goto rebuild;
+    *pUintId = word * META_WORD_BITS + CplCtz64(bits);
+    return 0;
+
+rebuild:
+    /*摘要与元数据区不一致（元数据被非法修改），重建摘要后顺序扫描。*/
+    LCMContainerRebuildSummary(container);
+    return LCMContainerScanFreeUnitId(container, pUintId);
+}
+
+/*
+ * 功能：判断地址是否为容器中某个内存单元的起始地址
+ * 返回值：是返回1，否则返回0。
+ */
+static inline char LCMContainerIsUnitAddr(LCMLinearContainer *container, void *addr)
+{
+    size_t offset = (uint8_t *)addr - container->base;
+
+    return (uint8_t *)addr >= container->base
+            && offset < (size_t)container->unitCount * container->unitSize
+            && offset % container->unitSize == 0;
+}
+
+/*
+ * 功能：根据元数据区重建空闲链表，用于检测到空闲链表被非法修改后的恢复。
+ * 返回值：无。
+ */
+static void LCMContainerRebuildFreeList(LCMLinearContainer *container)
+{
+    unsigned int u = container->nextUnitId;
+    uint8_t *unit;
+
+    container->freeList = NULL;
+    container->freeCount = container->unitCount - container->nextUnitId;
+    while (u-- > 0) {
+        if (LCDContainerGetUnitState(container, u) == UNIT_STATE_FREE) {
+            unit = container->base + (size_t)u * container->unitSize;
+            *(void **)unit = container->freeList;
+            container->freeList = unit;
+            container->freeCount++;
+        }
+    }
+}
+
+/*
+ * 功能：记录编号为unitId的内存单元被分配过，推进cleanUnitId和dirtyUnitId，调用者持有容器锁。
+ * 返回值：无。
+ */
+static inline void LCMContainerTouch(LCMLinearContainer *container, unsigned int unitId)
+{
+    if (unitId >= container->cleanUnitId)
+        container->cleanUnitId = unitId + 1;
+    if (unitId >= container->dirtyUnitId)
+        container->dirtyUnitId = unitId + 1;
+}
+
+/*
+ * 功能：空闲链表模式下从容器中分配一个内存单元，优先复用链表头部的单元，
+ *      链表为空时分配从未使用过的单元。
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+static void *LCMContainerListAlloc(LCMLinearContainer *container)
+{
+    uint8_t *unit;
+    void *next;
+
+    unit = container->freeList;
+    if (unit) {
+        next = *(void **)unit;
+        if (container->mode == LCM_MODE_FREELIST_CHECK
+                && ((next && !LCMContainerIsUnitAddr(container, next))
+                    || LCDContainerGetUnitState(container, (unit - container->base) / container->unitSize) != UNIT_STATE_FREE)) {
+            /*链表节点被非法修改，以元数据区为准重建链表。*/
+            LCMContainerRebuildFreeList(container);
+            return LCMContainerListAlloc(container);
+        }
+        container->freeList = next;
+    } else if (container->nextUnitId < container->unitCount) {
+        unit = container->base + (size_t)container->nextUnitId * container->unitSize;
+        LCMContainerTouch(container, container->nextUnitId);
+        container->nextUnitId++;
+    } else {
+        return NULL;
+    }
+    if (container->mode == LCM_MODE_FREELIST_CHECK) {
+        unsigned int unitId = (unit - container->base) / container->unitSize;
+
+        LCMMetaSetBit(&container->metas[0], unitId, UNIT_STATE_USED);
+        LCMMetaSetBit(&container->metas[1], unitId, UNIT_STATE_USED);
+    }
+    container->freeCount--;
+    return unit;
+}
+
 /*
  * 功能：从容器中分配一个内存单元。
  * 返回值：成功时返回地址指针，否则返回NULL。
@@ -153,11 +463,113 @@ static void *LCMContainerAlloc(LCMLinearContainer *container)
     unsigned int freeUnitId;
     int error = 0;
 
+    if (container->mode != LCM_MODE_BITMAP)
+        return LCMContainerListAlloc(container);
     error = LCMContainerGetFreeUnitId(container, &freeUnitId);
     if (error != -ENOERR)
         return NULL;
     LCMContainerSetUnitState(container, freeUnitId, UNIT_STATE_USED);
-    return container->base + freeUnitId * container->unitSize;
+    container->freeCount--;
+    LCMContainerTouch(container, freeUnitId);
+    return container->base + (size_t)freeUnitId * container->unitSize;
+}
+
+#ifdef LCM_LOCK_FREE
+/*每个线程查找空闲单元的起始字，不同线程从不同位置开始以分散竞争。*/
+static CPL_THREAD_LOCAL unsigned int lcmAllocHint;
+
+/*
+ * 功能：无锁地把cleanUnitId和dirtyUnitId推进到unitId之后，切换到加锁的模式后仍能判断哪些单元从未被分配过。
+ * 返回值：无
+ */
+static inline void LCMContainerTouchLockFree(LCMLinearContainer *container, unsigned int unitId)
+{
+    unsigned int clean = CplAtomicLoad(&container->cleanUnitId);
+    unsigned int dirty = CplAtomicLoad(&container->dirtyUnitId);
+
+    while (unitId >= clean
+            && !CplAtomicCas(&container->cleanUnitId, &clean, unitId + 1))
+        ;
+    while (unitId >= dirty
+            && !CplAtomicCas(&container->dirtyUnitId, &dirty, unitId + 1))
+        ;
+}
+
+/*
+ * 功能：无锁地从位图模式的容器中分配一个内存单元。
+ *      先在元数据区0上用CAS认领空闲位，成功后再设置元数据区1的对应位。
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+static void *LCMContainerAllocLockFree(LCMLinearContainer *container)
+{
+    uint64_t *m0 = container->metas[0].base;
+    uint64_t *m1 = container->metas[1].base;
+    unsigned int wordCount = container->metas[0].size / META_WORD_SIZE;
+    unsigned int w, i, bit;
+    uint64_t old, freeBits;
+
+    if (wordCount == 0)
+        return NULL;
+    if (lcmAllocHint == 0) {
+        /*按线程局部变量的地址散列出初始位置，并以8个字（一个缓存行）为间隔错开。*/
+        lcmAllocHint = (unsigned int)(((size_t)&lcmAllocHint >> 4) * 2654435761u) | 1;
+        lcmAllocHint *= 8;
+    }
+    w = lcmAllocHint % wordCount;
+    for (i = 0; i < wordCount; i++) {
+        old = CplAtomicLoad(&m0[w]);
+        while ((freeBits = ~(old | CplAtomicLoad(&m1[w]))) != 0) {
+            bit = CplCtz64(freeBits);
+            if (CplAtomicCas(&m0[w], &old, old | ((uint64_t)1 << bit))) {
+                CplAtomicFetchOr(&m1[w], (uint64_t)1 << bit);
+                lcmAllocHint = w;
+                LCMContainerTouchLockFree(container, w * META_WORD_BITS + bit);
+                return container->base + ((size_t)w * META_WORD_BITS + bit) * container->unitSize;
+            }
+        }
+        /*当前字已满，下次从下一个字开始查找。*/
+        if (++w == wordCount)
+            w = 0;
+    }
+    lcmAllocHint = w + 1;
+    return NULL;
+}
+
+/*
+ * 功能：无锁地释放位图模式容器中的一个内存单元。先清除元数据区1的对应位再清除元数据区0，
+ *      保证元数据区0中空闲的位在元数据区1中也是空闲的。
+ * 返回值：无。
+ */
+static void LCMContainerFreeLockFree(LCMLinearContainer *container, unsigned int unitId)
+{
+    unsigned int w = unitId / META_WORD_BITS;
+    uint64_t mask = (uint64_t)1 << (unitId % META_WORD_BITS);
+
+    /*元数据区1中的位已经是空闲状态时为重复释放。*/
+    if (!(CplAtomicFetchAnd(&container->metas[1].base[w], ~mask) & mask))
+        return;
+    CplAtomicFetchAnd(&container->metas[0].base[w], ~mask);
+}
+#endif
+
+/*
+ * 功能：获取容器中空闲内存单元的数量
+ * 返回值：空闲内存单元的数量。
+ */
+static unsigned int LCMContainerFreeUnitCount(LCMLinearContainer *container)
+{
+#ifdef LCM_LOCK_FREE
+    if (container->mode == LCM_MODE_BITMAP) {
+        unsigned int wordCount = container->metas[0].size / META_WORD_SIZE;
+        unsigned int w, count = 0;
+
+        for (w = 0; w < wordCount; w++)
+            count += CplPopcount64(~(CplAtomicLoad(&container->metas[0].base[w])
+                                     | CplAtomicLoad(&container->metas[1].base[w])));
+        return count;
+    }
+#endif
+    return container->freeCount;
 }
 
 /*
@@ -168,7 +580,8 @@ static int LCMContainerGetUnitId(LCMLinearContainer *container, void *addr, unsi
 {
     unsigned int unitId;
 
-    if ((unsigned int)addr % MEM_MAN_ALIGN_SIZE != 0)
+    if ((size_t)addr % MEM_MAN_ALIGN_SIZE != 0
+            || (uint8_t *)addr < container->base)
         return -EINVAL;
     unitId = ((uint8_t *)addr - container->base) / container->unitSize;
     if (unitId >= container->unitCount)
@@ -178,18 +591,62 @@ static int LCMContainerGetUnitId(LCMLinearContainer *container, void *addr, unsi
 }
 
 /*
- * 功能：容器释放一个内存单元
+ * 功能：容器释放编号为unitId的内存单元
  * 返回值：无。
  */
-static void LCMContainerFree(LCMLinearContainer *container, void *pointer)
+static void LCMContainerFree(LCMLinearContainer *container, unsigned int unitId)
 {
-    int error = 0;
-    unsigned int unitId;
+    if (container->mode != LCM_MODE_BITMAP) {
+        uint8_t *unit = container->base + (size_t)unitId * container->unitSize;
 
-    error = LCMContainerGetUnitId(container, pointer, &unitId);
-    if (error != -ENOERR)
+        /*空闲链表模式下把单元压入链表头部，检查模式下忽略重复释放。*/
+        if (container->mode == LCM_MODE_FREELIST_CHECK) {
+            if (unitId >= container->nextUnitId
+                    || LCDContainerGetUnitState(container, unitId) == UNIT_STATE_FREE)
+                return;
+            LCMMetaSetBit(&container->metas[0], unitId, UNIT_STATE_FREE);
+            LCMMetaSetBit(&container->metas[1], unitId, UNIT_STATE_FREE);
+        }
+        *(void **)unit = container->freeList;
+        container->freeList = unit;
+        container->freeCount++;
+        return;
+    }
+    /*重复释放时不改变空闲单元计数。*/
+    if (LCDContainerGetUnitState(container, unitId) == UNIT_STATE_FREE)
         return;
     LCMContainerSetUnitState(container, unitId, UNIT_STATE_FREE);
+    container->freeCount++;
+}
+
+/*
+ * 功能：设置容器的管理模式，只能在容器中所有内存单元都空闲时设置。
+ * ctnId: 容器编号
+ * mode: LCM_MODE_BITMAP、LCM_MODE_FREELIST或LCM_MODE_FREELIST_CHECK
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+int LCMSetContainerMode(LinearContainerMan *lcm, unsigned int ctnId, int mode)
+{
+    LCMLinearContainer *container;
+
+    if (!lcm || ctnId >= lcm->containerCount)
+        return -EINVAL;
+    if (mode != LCM_MODE_BITMAP
+            && mode != LCM_MODE_FREELIST
+            && mode != LCM_MODE_FREELIST_CHECK)
+        return -EINVAL;
+    container = &lcm->containers[ctnId];
+    CplLockAcquire(&container->lock);
+    if (LCMContainerFreeUnitCount(container) != container->unitCount) {
+        CplLockRelease(&container->lock);
+        return -EBUSY;
+    }
+    /*所有单元都空闲时元数据区全部为空闲状态，可以直接切换。*/
+    container->mode = mode;
+    container->freeList = NULL;
+    container->nextUnitId = 0;
+    CplLockRelease(&container->lock);
+    return 0;
 }
 
 /*
@@ -200,7 +657,17 @@ static int LCMSelectContainerIdBySize(LinearContainerMan *lcm, size_t size, unsi
 {
     unsigned int u;
 
-    for (u = 0; u < ARRAY_SIZE(lcm->containers); u++) {
+    /*小尺寸通过查找表直接得到容器编号。*/
+    if (size <= LCM_SIZE_LOOKUP_MAX) {
+        u = lcm->sizeClass[(size + LCM_SIZE_LOOKUP_GRAIN - 1) / LCM_SIZE_LOOKUP_GRAIN];
+        if (u == LCM_NO_CONTAINER)
+            return -ENOMEM;
+        *pId = u;
+        return 0;
+    }
+    if (size > lcm->maxUnitSize)
+        return -ENOMEM;
+    for (u = 0; u < lcm->containerCount; u++) {
         if (size <= lcm->containers[u].unitSize) {
             *pId = u;
             return 0;
@@ -209,6 +676,24 @@ static int LCMSelectContainerIdBySize(LinearContainerMan *lcm, size_t size, unsi
     return -ENOMEM;
 }
 
+/*
+ * 功能：从容器中申请一个内存单元，按照容器模式选择无锁或加锁的方式。
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+static void *LCMContainerAllocUnit(LCMLinearContainer *container)
+{
+    void *pointer;
+
+#ifdef LCM_LOCK_FREE
+    if (container->mode == LCM_MODE_BITMAP)
+        return LCMContainerAllocLockFree(container);
+#endif
+    CplLockAcquire(&container->lock);
+    pointer = LCMContainerAlloc(container);
+    CplLockRelease(&container->lock);
+    return pointer;
+}
+
 /*
  * 功能：从管理器申请size大小的内存
  * 返回值：成功时返回地址指针，否则返回NULL。
@@ -221,7 +706,204 @@ void *LCMAlloc(LinearContainerMan *lcm, size_t size)
     error = LCMSelectContainerIdBySize(lcm, size, &ctnId);
     if (error != -ENOERR)
         return NULL;
-    return LCMContainerAlloc(&lcm->containers[ctnId]);
+    return LCMContainerAllocUnit(&lcm->containers[ctnId]);
+}
+
+/*
+ * 功能：从管理器申请size大小、按align对齐的内存。从能够容纳size的第一个容器开始，
+ *      在内存单元满足对齐要求的容器中分配。
+ * align: 对齐尺寸，需要是2的幂
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+void *LCMAllocAligned(LinearContainerMan *lcm, size_t size, size_t align)
+{
+    LCMLinearContainer *container;
+    unsigned int ctnId;
+    void *pointer;
+
+    if (LCMSelectContainerIdBySize(lcm, size, &ctnId) != -ENOERR)
+        return NULL;
+    for (; ctnId < lcm->containerCount; ctnId++) {
+        container = &lcm->containers[ctnId];
+        if (container->unitCount == 0 || container->unitAlign < align)
+            continue;
+        pointer = LCMContainerAllocUnit(container);
+        if (pointer)
+            return pointer;
+    }
+    return NULL;
+}
+
+/*
+ * 功能：从管理器申请size大小并清零的内存。管理的内存初始全为0时，
+ *      从未被分配过的内存单元不需要清零。
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+void *LCMCalloc(LinearContainerMan *lcm, size_t size)
+{
+    LCMLinearContainer *container;
+    unsigned int ctnId, clean;
+    uint8_t *pointer;
+
+    if (LCMSelectContainerIdBySize(lcm, size, &ctnId) != -ENOERR)
+        return NULL;
+    container = &lcm->containers[ctnId];
+#ifdef LCM_LOCK_FREE
+    /*无锁模式下无法确定取得的单元是否被其它线程用过，总是清零。*/
+    if (container->mode == LCM_MODE_BITMAP) {
+        pointer = LCMContainerAllocLockFree(container);
+        if (pointer)
+            memset(pointer, 0, size);
+        return pointer;
+    }
+#endif
+    CplLockAcquire(&container->lock);
+    clean = container->cleanUnitId;
+    pointer = LCMContainerAlloc(container);
+    CplLockRelease(&container->lock);
+    if (pointer && !(lcm->zeroed
+                     && (size_t)(pointer - container->base) / container->unitSize >= clean))
+        memset(pointer, 0, size);
+    return pointer;
+}
+
+/*
+ * 功能：根据请求的内存尺寸获取容器编号
+ * 返回值：成功时返回0，没有合适的容器时返回错误码。
+ */
+int LCMSizeToClass(LinearContainerMan *lcm, size_t size, unsigned int *pCtnId)
+{
+    return LCMSelectContainerIdBySize(lcm, size, pCtnId);
+}
+
+/*
+ * 功能：位图模式下从容器中批量分配内存单元。每次沿摘要位图找到一个有空闲位的字，
+ *      一次认领其中最多n个空闲位，每个字只更新一次元数据区和摘要位图。调用者持有容器锁。
+ * out: 保存分配到的地址
+ * 返回值：实际分配到的内存单元数量。
+ */
+static unsigned int LCMContainerAllocWords(LCMLinearContainer *container, void **out, unsigned int n)
+{
+    unsigned int i = 0, word, bit = 0, unitId;
+    uint64_t freeBits, taken;
+
+    while (i < n && LCMContainerGetFreeUnitId(container, &unitId) == -ENOERR) {
+        word = unitId / META_WORD_BITS;
+        freeBits = ~(container->metas[0].base[word] | container->metas[1].base[word]);
+        for (taken = 0; freeBits && i < n; freeBits &= freeBits - 1) {
+            bit = CplCtz64(freeBits);
+            taken |= (uint64_t)1 << bit;
+            out[i++] = container->base + ((size_t)word * META_WORD_BITS + bit) * container->unitSize;
+        }
+        container->metas[0].base[word] |= taken;
+        container->metas[1].base[word] |= taken;
+        LCMSummaryUpdate(container, word,
+                         (container->metas[0].base[word] | container->metas[1].base[word]) != META_WORD_FULL);
+        container->freeCount -= CplPopcount64(taken);
+        /*按比特位升序认领，最后一个即为编号最大的单元。*/
+        LCMContainerTouch(container, word * META_WORD_BITS + bit);
+    }
+    return i;
+}
+
+/*
+ * 功能：位图模式下释放元数据区第word个字中mask对应的内存单元，已经空闲的单元被忽略。调用者持有容器锁。
+ * 返回值：无。
+ */
+static void LCMContainerFreeWord(LCMLinearContainer *container, unsigned int word, uint64_t mask)
+{
+    mask &= container->metas[0].base[word] | container->metas[1].base[word];
+    if (!mask)
+        return;
+    container->metas[0].base[word] &= ~mask;
+    container->metas[1].base[word] &= ~mask;
+    LCMSummaryUpdate(container, word, 1);
+    container->freeCount += CplPopcount64(mask);
+}
+
+/*
+ * 功能：从编号为ctnId的容器中一次分配最多n个内存单元，整个过程只获取一次容器锁。
+ *      位图模式下按元数据区的字认领空闲单元。
+ * out: 保存分配到的地址
+ * 返回值：实际分配到的内存单元数量。
+ */
+unsigned int LCMAllocBulk(LinearContainerMan *lcm, unsigned int ctnId, void **out, unsigned int n)
+{
+    LCMLinearContainer *container;
+    unsigned int i;
+
+    if (ctnId >= lcm->containerCount)
+        return 0;
+    container = &lcm->containers[ctnId];
+#ifdef LCM_LOCK_FREE
+    if (container->mode == LCM_MODE_BITMAP) {
+        for (i = 0; i < n; i++) {
+            out[i] = LCMContainerAllocLockFree(container);
+            if (!out[i])
+                break;
+        }
+        return i;
+    }
+#endif
+    CplLockAcquire(&container->lock);
+    if (container->mode == LCM_MODE_BITMAP) {
+        i = LCMContainerAllocWords(container, out, n);
+    } else {
+        for (i = 0; i < n; i++) {
+            out[i] = LCMContainerAlloc(container);
+            if (!out[i])
+                break;
+        }
+    }
+    CplLockRelease(&container->lock);
+    return i;
+}
+
+/*
+ * 功能：向编号为ctnId的容器一次释放n个内存单元，整个过程只获取一次容器锁。
+ *      不属于该容器的地址被忽略。位图模式下地址按升序排列时，同一个字中的单元一次释放。
+ * 返回值：无。
+ */
+void LCMFreeBulk(LinearContainerMan *lcm, unsigned int ctnId, void * const *ptrs, unsigned int n)
+{
+    LCMLinearContainer *container;
+    unsigned int i, unitId, word = 0;
+    uint64_t mask = 0;
+
+    if (ctnId >= lcm->containerCount)
+        return;
+    container = &lcm->containers[ctnId];
+#ifdef LCM_LOCK_FREE
+    if (container->mode == LCM_MODE_BITMAP) {
+        for (i = 0; i < n; i++) {
+            if (LCMContainerGetUnitId(container, ptrs[i], &unitId) == -ENOERR)
+                LCMContainerFreeLockFree(container, unitId);
+        }
+        return;
+    }
+#endif
+    CplLockAcquire(&container->lock);
+    if (container->mode == LCM_MODE_BITMAP) {
+        /*连续落在元数据区同一个字中的单元合并为一次释放。*/
+        for (i = 0; i < n; i++) {
+            if (LCMContainerGetUnitId(container, ptrs[i], &unitId) != -ENOERR)
+                continue;
+            if (mask && unitId / META_WORD_BITS != word) {
+                LCMContainerFreeWord(container, word, mask);
+                mask = 0;
+            }
+            word = unitId / META_WORD_BITS;
+            mask |= (uint64_t)1 << (unitId % META_WORD_BITS);
+        }
+        if (mask)
+            LCMContainerFreeWord(container, word, mask);
+    } else {
+        for (i = 0; i < n; i++) {
+            if (LCMContainerGetUnitId(container, ptrs[i], &unitId) == -ENOERR)
+                LCMContainerFree(container, unitId);
+        }
+    }
+    CplLockRelease(&container->lock);
 }
 
 /*
@@ -233,10 +915,10 @@ static int LCMSelectContainerIdByAddr(LinearContainerMan *lcm, void *addr, unsig
     unsigned int u;
     LCMLinearContainer *container;
 
-    for (u = 0; u < ARRAY_SIZE(lcm->containers); u++) {
+    for (u = 0; u < lcm->containerCount; u++) {
         container = &lcm->containers[u];
         if ((uint8_t *)addr >= container->base
-                && (uint8_t *)addr < container->base + container->unitCount * container->unitSize) {
+                && (uint8_t *)addr < container->base + (size_t)container->unitCount * container->unitSize) {
             *pId = u;
             return 0;
         }
@@ -244,65 +926,275 @@ static int LCMSelectContainerIdByAddr(LinearContainerMan *lcm, void *addr, unsig
     return -EINVAL;
 }
 
+/*
+ * 功能：根据地址查找其所在的容器和内存单元。
+ *      通过归属表定位，只需读取归属表的一项和至多两个容器的描述信息。
+ * pCtnId: 容器编号
+ * pUnitId: 内存单元编号，可以为NULL
+ * 返回值：成功时返回0，地址不属于线性容器管理器时返回错误码。
+ */
+int LCMLookup(LinearContainerMan *lcm, void *pointer, unsigned int *pCtnId, unsigned int *pUnitId)
+{
+    uint8_t *addr = pointer;
+    LCMLinearContainer *container;
+    unsigned int ctnId, unitId;
+    uint16_t entry;
+    int error;
+
+    if (!LCMIsOwner(lcm, pointer))
+        return -EINVAL;
+    if (lcm->ownerMap) {
+        /*一个粒度块中最多包含一个容器边界，地址超出粒度块起始处容器的内存单元区时属于下一个容器。*/
+        entry = lcm->ownerMap[(size_t)(addr - lcm->memBase) >> lcm->ownerShift];
+        ctnId = entry & 0xFF;
+        container = &lcm->containers[ctnId];
+        if (addr >= container->base + (size_t)container->unitCount * container->unitSize)
+            ctnId = entry >> 8;
+    } else {
+        error = LCMSelectContainerIdByAddr(lcm, pointer, &ctnId);
+        if (error != -ENOERR)
+            return error;
+    }
+    error = LCMContainerGetUnitId(&lcm->containers[ctnId], pointer, &unitId);
+    if (error != -ENOERR)
+        return error;
+    *pCtnId = ctnId;
+    if (pUnitId)
+        *pUnitId = unitId;
+    return 0;
+}
+
 /*
  * 功能：向管理器释放内存空间。
  * 返回值：无。
  */
 void LCMFree(LinearContainerMan *lcm, void *pointer)
 {
-    unsigned int ctnId = 0;
+    unsigned int ctnId = 0, unitId;
     int error;
 
     if (!pointer)
         return;
-    error = LCMSelectContainerIdByAddr(lcm, pointer, &ctnId);
+    error = LCMLookup(lcm, pointer, &ctnId, &unitId);
     if (error != -ENOERR)
         return;
-    LCMContainerFree(&lcm->containers[ctnId], pointer);
+#ifdef LCM_LOCK_FREE
+    if (lcm->containers[ctnId].mode == LCM_MODE_BITMAP) {
+        LCMContainerFreeLockFree(&lcm->containers[ctnId], unitId);
+        return;
+    }
+#endif
+    CplLockAcquire(&lcm->containers[ctnId].lock);
+    LCMContainerFree(&lcm->containers[ctnId], unitId);
+    CplLockRelease(&lcm->containers[ctnId].lock);
+}
+
+/*默认容器配置，来自linear_containers_define.h中的定义。*/
+static const LCMClassConfig lcmDefaultClasses[] = {
+    {CONTAINER0_UNIT_SIZE,  CONTAINER0_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER1_UNIT_SIZE,  CONTAINER1_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER2_UNIT_SIZE,  CONTAINER2_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER3_UNIT_SIZE,  CONTAINER3_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER4_UNIT_SIZE,  CONTAINER4_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER5_UNIT_SIZE,  CONTAINER5_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER6_UNIT_SIZE,  CONTAINER6_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER7_UNIT_SIZE,  CONTAINER7_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+
+    {CONTAINER8_UNIT_SIZE,  CONTAINER8_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER9_UNIT_SIZE,  CONTAINER9_UNIT_COUNT,  LCM_DEFAULT_MODE, 0},
+    {CONTAINER10_UNIT_SIZE, CONTAINER10_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER11_UNIT_SIZE, CONTAINER11_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER12_UNIT_SIZE, CONTAINER12_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER13_UNIT_SIZE, CONTAINER13_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER14_UNIT_SIZE, CONTAINER14_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER15_UNIT_SIZE, CONTAINER15_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+
+    {CONTAINER16_UNIT_SIZE, CONTAINER16_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER17_UNIT_SIZE, CONTAINER17_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER18_UNIT_SIZE, CONTAINER18_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER19_UNIT_SIZE, CONTAINER19_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER20_UNIT_SIZE, CONTAINER20_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER21_UNIT_SIZE, CONTAINER21_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER22_UNIT_SIZE, CONTAINER22_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER23_UNIT_SIZE, CONTAINER23_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+
+    {CONTAINER24_UNIT_SIZE, CONTAINER24_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER25_UNIT_SIZE, CONTAINER25_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER26_UNIT_SIZE, CONTAINER26_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER27_UNIT_SIZE, CONTAINER27_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER28_UNIT_SIZE, CONTAINER28_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER29_UNIT_SIZE, CONTAINER29_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER30_UNIT_SIZE, CONTAINER30_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+    {CONTAINER31_UNIT_SIZE, CONTAINER31_UNIT_COUNT, LCM_DEFAULT_MODE, 0},
+};
+
+/*
+ * 功能：根据容器的内存单元尺寸建立尺寸查找表。
+ * 返回值：无。
+ */
+static void LCMBuildSizeClass(LinearContainerMan *lcm)
+{
+    unsigned int u = 0;
+    size_t n;
+
+    lcm->maxUnitSize = 0;
+    for (n = 0; n < ARRAY_SIZE(lcm->sizeClass); n++) {
+        while (u < lcm->containerCount
+                && lcm->containers[u].unitSize < n * LCM_SIZE_LOOKUP_GRAIN)
+            u++;
+        lcm->sizeClass[n] = u < lcm->containerCount ? u : LCM_NO_CONTAINER;
+    }
+    if (lcm->containerCount > 0)
+        lcm->maxUnitSize = lcm->containers[lcm->containerCount - 1].unitSize;
+}
+
+/*
+ * 功能：建立归属表。把线性容器占用的内存按2的幂划分为粒度块，粒度不超过最小的容器跨度，
+ *      因此每个粒度块中最多包含一个容器边界。归属表从剩余内存中分配。
+ * spanEnd: 各容器占用内存的结束地址，内存单元数量为0的容器不占用内存
+ * pRemain: 剩余内存尺寸，分配归属表后更新
+ * 返回值：无。剩余内存不足时不建立归属表，查找时退化为顺序查找。
+ */
+static void LCMBuildOwnerMap(LinearContainerMan *lcm, uint8_t * const *spanEnd, size_t *pRemain)
+{
+    size_t minSpan = (size_t)-1, mapCount, mapBytes, k;
+    uint8_t *spanStart = lcm->memBase, *addr;
+    unsigned int u, cur = LCM_NO_CONTAINER, next;
+
+    lcm->ownerMap = NULL;
+    lcm->ownerShift = 0;
+    for (u = 0; u < lcm->containerCount; u++) {
+        if (lcm->containers[u].unitCount == 0)
+            continue;
+        if ((size_t)(spanEnd[u] - spanStart) < minSpan)
+            minSpan = spanEnd[u] - spanStart;
+        spanStart = spanEnd[u];
+    }
+    if (lcm->memEnd == lcm->memBase)
+        return;
+    while (((size_t)2 << lcm->ownerShift) <= minSpan)
+        lcm->ownerShift++;
+    mapCount = ((size_t)(lcm->memEnd - lcm->memBase) + ((size_t)1 << lcm->ownerShift) - 1) >> lcm->ownerShift;
+    mapBytes = mapCount * sizeof (uint16_t) + sizeof (uint16_t);
+    if (*pRemain < mapBytes)
+        return;
+    lcm->ownerMap = (uint16_t *)(lcm->memEnd + (size_t)lcm->memEnd % sizeof (uint16_t));
+    *pRemain -= mapBytes;
+
+    /*记录每个粒度块起始地址所在的容器，以及该容器之后的下一个有效容器。*/
+    u = 0;
+    for (k = 0; k < mapCount; k++) {
+        addr = lcm->memBase + (k << lcm->ownerShift);
+        while (u < lcm->containerCount
+                && (lcm->containers[u].unitCount == 0 || spanEnd[u] <= addr))
+            u++;
+        cur = u;
+        for (next = cur + 1; next < lcm->containerCount && lcm->containers[next].unitCount == 0; next++)
+            ;
+        if (next >= lcm->containerCount)
+            next = cur;
+        lcm->ownerMap[k] = (uint16_t)(cur | (next << 8));
+    }
 }
 
 /*
- * 功能：线性容器管理器初始化
+ * 功能：按照运行时提供的容器配置初始化线性容器管理器
  * lcm: 线性容器管理器
  * buf：管理的内存基地址
  * size：管理的内存尺寸
+ * pRemain：给容器分配完内存后的剩余量
+ * classes：容器配置表，需要按内存单元尺寸升序排列
+ * classCount：容器配置数量，不超过LCM_MAX_CONTAINERS
  * 返回值：成功时返回0，否则返回错误码。
  */
-int LCMInit(LinearContainerMan *lcm, uint8_t *buf, size_t size, size_t *pRemain)
+int LCMInitWithConfig(LinearContainerMan *lcm, uint8_t *buf, size_t size, size_t *pRemain,
+                      const LCMClassConfig *classes, size_t classCount)
 {
+    uint8_t *spanEnd[LCM_MAX_CONTAINERS];
     size_t remain;
     size_t i;
 
     if (!lcm)
         return -EINVAL;
-    for (i = 0; i < ARRAY_SIZE(lcm->containers); i++) {
-        LCMContainerInitUnit(&lcm->containers[i], i);
+    lcm->containerCount = 0;
+    lcm->memBase = lcm->memEnd = NULL;
+    lcm->ownerMap = NULL;
+    lcm->zeroed = 0;
+    if (!classes || classCount > LCM_MAX_CONTAINERS)
+        return -EINVAL;
+    for (i = 0; i < classCount; i++) {
+        if ((i > 0 && classes[i].unitSize < classes[i-1].unitSize)
+                || (classes[i].mode != LCM_MODE_BITMAP
+                    && classes[i].mode != LCM_MODE_FREELIST
+                    && classes[i].mode != LCM_MODE_FREELIST_CHECK)
+                || (classes[i].align & (classes[i].align - 1))
+                || (classes[i].align && classes[i].unitSize % classes[i].align))
+            return -EINVAL;
     }
+
+    lcm->containerCount = classCount;
+    for (i = 0; i < classCount; i++) {
+        CplLockInit(&lcm->containers[i].lock);
+        lcm->containers[i].unitSize = classes[i].unitSize;
+        lcm->containers[i].unitCount = classes[i].unitCount;
+        lcm->containers[i].mode = classes[i].mode;
+        lcm->containers[i].unitAlign = classes[i].align > MEM_MAN_ALIGN_SIZE ? classes[i].align : MEM_MAN_ALIGN_SIZE;
+    }
+    LCMBuildSizeClass(lcm);
     if (!buf) {
-        for (i = 0; i < ARRAY_SIZE(lcm->containers); i++) {
+        for (i = 0; i < lcm->containerCount; i++) {
             LCMContainerInit(&lcm->containers[i], NULL, 0, NULL);
         }
         return -EINVAL;
     }
 
     remain = size;
-    for (i = 0; i < ARRAY_SIZE(lcm->containers); i++) {
+    for (i = 0; i < lcm->containerCount; i++) {
         LCMContainerInit(&lcm->containers[i], &buf[size-remain], remain, &remain);
+        spanEnd[i] = &buf[size-remain];
     }
+    lcm->memBase = buf;
+    lcm->memEnd = &buf[size-remain];
+    LCMBuildOwnerMap(lcm, spanEnd, &remain);
     if (pRemain)
         *pRemain = remain;
     return 0;
 }
 
+/*
+ * 功能：线性容器管理器初始化，使用linear_containers_define.h中定义的默认容器配置。
+ * lcm: 线性容器管理器
+ * buf：管理的内存基地址
+ * size：管理的内存尺寸
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+int LCMInit(LinearContainerMan *lcm, uint8_t *buf, size_t size, size_t *pRemain)
+{
+    return LCMInitWithConfig(lcm, buf, size, pRemain, lcmDefaultClasses, CONTAINER_SIZE);
+}
+
+/*
+ * 功能：释放线性容器管理器中的所有内存单元，保留容器配置和内存布局，不重新初始化元数据区。
+ *      调用时不能有其他线程同时访问管理器。
+ * 返回值：无。
+ */
+void LCMReset(LinearContainerMan *lcm)
+{
+    unsigned int i;
+
+    for (i = 0; i < lcm->containerCount; i++)
+        LCMContainerReset(&lcm->containers[i]);
+}
+
 static void LCDMetaPrint(LCMCtnMeta *meta, unsigned int id)
 {
     printf("............\n");
     printf("meta%d:\n", id);
     printf("meta base: %p(H)\n", meta->base);
-    printf("meta size: %u\n", meta->size);
+    printf("meta size: %zu\n", meta->size);
     printf("meta hex image:\n");
-    for (uint32_t k = 0; k < meta->size; k++) {
-        printf("%02x ", meta->base[k]);
+    for (size_t k = 0; k < meta->size; k++) {
+        printf("%02x ", ((uint8_t *)meta->base)[k]);
         if (!((k+1) % 16))
             printf("\n");
     }
@@ -315,24 +1207,30 @@ static void LCMContainerPrint(LCMLinearContainer *container)
 
     LCDMetaPrint(&container->metas[0], 0);
     LCDMetaPrint(&container->metas[1], 1);
-    for (uint32_t t = 0; t < container->unitCount; t++) {
-        if (!LCMMetaGetBit(&container->metas[0], t))
-            freeUnitCount++;
+    if (container->mode == LCM_MODE_FREELIST) {
+        freeUnitCount = LCMContainerFreeUnitCount(container);
+    } else {
+        for (uint32_t t = 0; t < container->unitCount; t++) {
+            if (LCDContainerGetUnitState(container, t) == UNIT_STATE_FREE)
+                freeUnitCount++;
+        }
     }
     printf("............\n");
+    printf("mode: %d\n", container->mode);
     printf("container base: %p(H)\n", container->base);
     printf("unit size: %u\n", container->unitSize);
     printf("unit count: %u\n", container->unitCount);
-    printf("total space size: %u\n", container->unitCount * container->unitSize);
-    printf("free space size: %u\n", freeUnitCount * container->unitSize);
-    printf("used space size: %u\n", (container->unitCount - freeUnitCount) * container->unitSize);
+    printf("free unit count: %u\n", LCMContainerFreeUnitCount(container));
+    printf("total space size: %zu\n", (size_t)container->unitCount * container->unitSize);
+    printf("free space size: %zu\n", (size_t)freeUnitCount * container->unitSize);
+    printf("used space size: %zu\n", (size_t)(container->unitCount - freeUnitCount) * container->unitSize);
 }
 
 void LCMPrint(LinearContainerMan *lcm)
 {
     uint32_t e;
 
-    for (e = 0; e < ARRAY_SIZE(lcm->containers); e++) {
+    for (e = 0; e < lcm->containerCount; e++) {
         printf("------------container%d-------------------------\n", e);
         LCMContainerPrint(&lcm->containers[e]);
     }
@@ -342,7 +1240,7 @@ void LCMExample(void)
 {
     LinearContainerMan memManx, *memMan = &memManx;
     uint8_t buf[2048];
-    unsigned int remain;
+    size_t remain;
 
     LCMInit(memMan, buf, sizeof (buf), &remain);
 
@@ -382,3 +1280,76 @@ void LCMExample(void)
     p = LCMAlloc(memMan, 33);
     printf("addrx: %p\n", p);
 }
+
+/*
+ * 功能：线性容器分配性能测试，输出不同占用率下分配并释放一个内存单元的平均耗时。
+ * 返回值：无。
+ */
+void LCMBenchmark(void)
+{
+    static uint8_t buf[64 * 1024];
+    static void *addr[CONTAINER3_UNIT_COUNT];
+    static unsigned int order[CONTAINER3_UNIT_COUNT];
+    const int modes[] = {LCM_MODE_BITMAP, LCM_MODE_FREELIST, LCM_MODE_FREELIST_CHECK};
+    LinearContainerMan lcmx, *lcm = &lcmx;
+    const unsigned int rounds = 200000;
+    unsigned int occupancy, used, i, r;
+    unsigned int m, k, t;
+    size_t remain;
+    clock_t start;
+    double ns;
+    void *p;
+
+    printf("occupancy(%%)  alloc+free(ns)\n");
+    for (occupancy = 0; occupancy <= 100; occupancy += 10) {
+        LCMInit(lcm, buf, sizeof (buf), &remain);
+        used = CONTAINER3_UNIT_COUNT * occupancy / 100;
+        if (occupancy == 100)
+            used--;     /*保留一个空闲单元，测量最坏情况的查找。*/
+        for (i = 0; i < used; i++)
+            addr[i] = LCMAlloc(lcm, CONTAINER3_UNIT_SIZE);
+
+        start = clock();
+        for (r = 0; r < rounds; r++) {
+            p = LCMAlloc(lcm, CONTAINER3_UNIT_SIZE);
+            LCMFree(lcm, p);
+        }
+        ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / rounds;
+        printf("%12u  %14.1f\n", occupancy, ns);
+    }
+
+    /*位图模式和空闲链表模式在后进先出和随机释放顺序下的对比。*/
+    printf("mode  order   alloc+free(ns)\n");
+    for (m = 0; m < ARRAY_SIZE(modes); m++) {
+        for (k = 0; k < 2; k++) {
+            LCMInit(lcm, buf, sizeof (buf), &remain);
+            LCMSetContainerMode(lcm, 3, modes[m]);
+            for (i = 0; i < CONTAINER3_UNIT_COUNT; i++)
+                order[i] = i;
+            if (k == 1) {
+                srand(1);
+                for (i = CONTAINER3_UNIT_COUNT - 1; i > 0; i--) {
+                    t = rand() % (i + 1);
+                    used = order[i];
+                    order[i] = order[t];
+                    order[t] = used;
+                }
+            }
+            start = clock();
+            for (r = 0; r < rounds / CONTAINER3_UNIT_COUNT; r++) {
+                for (i = 0; i < CONTAINER3_UNIT_COUNT; i++)
+                    addr[i] = LCMAlloc(lcm, CONTAINER3_UNIT_SIZE);
+                if (k == 0) {
+                    for (i = CONTAINER3_UNIT_COUNT; i-- > 0; )
+                        LCMFree(lcm, addr[i]);
+                } else {
+                    for (i = 0; i < CONTAINER3_UNIT_COUNT; i++)
+                        LCMFree(lcm, addr[order[i]]);
+                }
+            }
+            ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC
+                    / (rounds / CONTAINER3_UNIT_COUNT * CONTAINER3_UNIT_COUNT);
+            printf("%4d  %-6s  %14.1f\n", modes[m], k == 0 ? "lifo" : "random", ns);
+        }
+    }
+}
@@ -6,172 +6,109 @@ extern "C" {
 #endif
 
 #include "stdint.h"
+#include "stddef.h"
 #include "linear_containers_define.h"
+#include "cpl_lock.h"
 
-/*线性容器元数据*/
+/*线性容器元数据，按64位字组织的位图，一个比特位对应一个内存单元。*/
 typedef struct {
-    uint8_t *base;  /*基地址*/
-    uint32_t size;  /*元数据尺寸*/
+    uint64_t *base; /*基地址，8字节对齐*/
+    size_t size;    /*元数据尺寸（字节），是8的整数倍*/
 } LCMCtnMeta;
 
+/*摘要位图的最大层数，每层一个比特位对应下一层的一个64位字，最多支持pow(64, 4)个内存单元。*/
+#define LCM_SUMMARY_LEVELS      3
+
+/*线性容器的内存单元管理模式*/
+#define LCM_MODE_BITMAP             0   /*位图模式：通过元数据区和摘要位图查找空闲单元*/
+#define LCM_MODE_FREELIST           1   /*空闲链表模式：空闲单元内部保存下一个空闲单元的地址*/
+#define LCM_MODE_FREELIST_CHECK     2   /*空闲链表模式，同时维护元数据区用于检测重复释放*/
+
+/*容器默认的管理模式*/
+#ifndef LCM_DEFAULT_MODE
+#define LCM_DEFAULT_MODE            LCM_MODE_BITMAP
+#endif
+
+/*定义后位图模式的容器通过原子操作认领和释放内存单元，分配和释放不加锁。
+    此时不维护摘要位图和空闲单元计数，容器模式只能在初始化后、开始分配前设置。*/
+//#define LCM_LOCK_FREE
+
 /*线性容器*/
 typedef struct _LCMLinearContainer {
     LCMCtnMeta metas[2];
+    uint64_t *summary[LCM_SUMMARY_LEVELS];  //摘要位图，比特位为1表示对应的字中有空闲单元
+    unsigned int summaryLevels; //摘要位图的有效层数
+    unsigned int freeCount;     //空闲内存单元数量
+    int mode;                   //管理模式，LCM_MODE_XXX
+    void *freeList;             //空闲链表模式下的链表头
+    unsigned int nextUnitId;    //空闲链表模式下从未分配过的第一个内存单元
+    unsigned int cleanUnitId;   //从该编号开始的内存单元从未被分配过
+    unsigned int dirtyUnitId;   //从该编号开始的内存单元在上次重置后没有被分配过
+    CplLock lock;               //容器锁，不同容器的分配和释放互不影响
     uint8_t *base;              //对齐后的基地址
+    unsigned int unitAlign;     //所有内存单元都满足的对齐尺寸
     unsigned int unitSize;      //内存管理单元大小
     unsigned int unitCount;     //内存管理单元数量
 } LCMLinearContainer;
 
+/*容器数量上限*/
+#define LCM_MAX_CONTAINERS          32
+
+/*尺寸查找表的粒度和覆盖的最大尺寸，超过该尺寸的请求顺序查找容器。*/
+#define LCM_SIZE_LOOKUP_GRAIN       8
+#define LCM_SIZE_LOOKUP_MAX         4096
+
+/*尺寸查找表中表示没有可用容器*/
+#define LCM_NO_CONTAINER            0xFF
+
+/*容器配置，描述一个尺寸等级。*/
+typedef struct {
+    unsigned int unitSize;      /*内存单元尺寸，需要被8整除，可以不是2的幂*/
+    unsigned int unitCount;     /*内存单元数量*/
+    int mode;                   /*管理模式，LCM_MODE_XXX*/
+    unsigned int align;         /*内存单元的对齐尺寸，需要是2的幂且整除unitSize，为0时按MEM_MAN_ALIGN_SIZE对齐。
+                                    例如unitSize为2的幂时，align取unitSize可使每个内存单元都按自身尺寸对齐。*/
+} LCMClassConfig;
+
 /*线性容器管理器*/
 typedef struct _LinearContainerMan {
-    LCMLinearContainer containers[CONTAINER_SIZE];
+    LCMLinearContainer containers[LCM_MAX_CONTAINERS];
+    unsigned int containerCount;    /*有效容器数量*/
+    size_t maxUnitSize;             /*最大的内存单元尺寸*/
+    /*尺寸查找表，第n项为能够容纳n*LCM_SIZE_LOOKUP_GRAIN字节的第一个容器的编号。*/
+    uint8_t sizeClass[LCM_SIZE_LOOKUP_MAX / LCM_SIZE_LOOKUP_GRAIN + 1];
+    uint8_t *memBase;               /*容器占用内存的起始地址*/
+    uint8_t *memEnd;                /*容器占用内存的结束地址*/
+    /*归属表，每项对应pow(2, ownerShift)字节的粒度块，低8位为粒度块起始地址所在的容器编号，
+        高8位为其后的下一个容器编号。*/
+    uint16_t *ownerMap;
+    unsigned int ownerShift;
+    uint8_t zeroed;                 /*管理的内存初始全为0，从未被分配过的内存单元无需清零*/
 } LinearContainerMan;
 
 int LCMInit(LinearContainerMan *lcm, uint8_t *buf, size_t size, size_t *pRemain);
+int LCMInitWithConfig(LinearContainerMan *lcm, uint8_t *buf, size_t size, size_t *pRemain,
+                      const LCMClassConfig *classes, size_t classCount);
 void *LCMAlloc(LinearContainerMan *lcm, size_t size);
+void *LCMAllocAligned(LinearContainerMan *lcm, size_t size, size_t align);
+void *LCMCalloc(LinearContainerMan *lcm, size_t size);
 void LCMFree(LinearContainerMan *lcm, void *pointer);
+void LCMReset(LinearContainerMan *lcm);
+int LCMLookup(LinearContainerMan *lcm, void *pointer, unsigned int *pCtnId, unsigned int *pUnitId);
+int LCMSizeToClass(LinearContainerMan *lcm, size_t size, unsigned int *pCtnId);
+unsigned int LCMAllocBulk(LinearContainerMan *lcm, unsigned int ctnId, void **out, unsigned int n);
+void LCMFreeBulk(LinearContainerMan *lcm, unsigned int ctnId, void * const *ptrs, unsigned int n);
+int LCMSetContainerMode(LinearContainerMan *lcm, unsigned int ctnId, int mode);
 
 void LCMPrint(LinearContainerMan *lcm);
 
 /*
- * 功能：初始化容器的内存单元尺寸和内存单元数量
- * 返回值：
+ * 功能：判断地址是否位于线性容器管理器管理的内存中
+ * 返回值：是返回1，否则返回0。
  */
-static inline void LCMContainerInitUnit(LCMLinearContainer *container, size_t pos)
+static inline char LCMIsOwner(LinearContainerMan *lcm, void *pointer)
 {
-    switch (pos) {
-    case 0:
-        container->unitSize = CONTAINER0_UNIT_SIZE;
-        container->unitCount = CONTAINER0_UNIT_COUNT;
-        break;
-    case 1:
-        container->unitSize = CONTAINER1_UNIT_SIZE;
-        container->unitCount = CONTAINER1_UNIT_COUNT;
-        break;
-    case 2:
-        container->unitSize = CONTAINER2_UNIT_SIZE;
-        container->unitCount = CONTAINER2_UNIT_COUNT;
-        break;
-    case 3:
-        container->unitSize = CONTAINER3_UNIT_SIZE;
-        container->unitCount = CONTAINER3_UNIT_COUNT;
-        break;
-    case 4:
-        container->unitSize = CONTAINER4_UNIT_SIZE;
-        container->unitCount = CONTAINER4_UNIT_COUNT;
-        break;
-    case 5:
-        container->unitSize = CONTAINER5_UNIT_SIZE;
-        container->unitCount = CONTAINER5_UNIT_COUNT;
-        break;
-    case 6:
-        container->unitSize = CONTAINER6_UNIT_SIZE;
-        container->unitCount = CONTAINER6_UNIT_COUNT;
-        break;
-    case 7:
-        container->unitSize = CONTAINER7_UNIT_SIZE;
-        container->unitCount = CONTAINER7_UNIT_COUNT;
-        break;
-
-    case 8:
-        container->unitSize = CONTAINER8_UNIT_SIZE;
-        container->unitCount = CONTAINER8_UNIT_COUNT;
-        break;
-    case 9:
-        container->unitSize = CONTAINER9_UNIT_SIZE;
-        container->unitCount = CONTAINER9_UNIT_COUNT;
-        break;
-    case 10:
-        container->unitSize = CONTAINER10_UNIT_SIZE;
-        container->unitCount = CONTAINER10_UNIT_COUNT;
-        break;
-    case 11:
-        container->unitSize = CONTAINER11_UNIT_SIZE;
-        container->unitCount = CONTAINER11_UNIT_COUNT;
-        break;
-    case 12:
-        container->unitSize = CONTAINER12_UNIT_SIZE;
-        container->unitCount = CONTAINER12_UNIT_COUNT;
-        break;
-    case 13:
-        container->unitSize = CONTAINER13_UNIT_SIZE;
-        container->unitCount = CONTAINER13_UNIT_COUNT;
-        break;
-    case 14:
-        container->unitSize = CONTAINER14_UNIT_SIZE;
-        container->unitCount = CONTAINER14_UNIT_COUNT;
-        break;
-    case 15:
-        container->unitSize = CONTAINER15_UNIT_SIZE;
-        container->unitCount = CONTAINER15_UNIT_COUNT;
-        break;
-
-    case 16:
-        container->unitSize = CONTAINER16_UNIT_SIZE;
-        container->unitCount = CONTAINER16_UNIT_COUNT;
-        break;
-    case 17:
-        container->unitSize = CONTAINER17_UNIT_SIZE;
-        container->unitCount = CONTAINER17_UNIT_COUNT;
-        break;
-    case 18:
-        container->unitSize = CONTAINER18_UNIT_SIZE;
-        container->unitCount = CONTAINER18_UNIT_COUNT;
-        break;
-    case 19:
-        container->unitSize = CONTAINER19_UNIT_SIZE;
-        container->unitCount = CONTAINER19_UNIT_COUNT;
-        break;
-    case 20:
-        container->unitSize = CONTAINER20_UNIT_SIZE;
-        container->unitCount = CONTAINER20_UNIT_COUNT;
-        break;
-    case 21:
-        container->unitSize = CONTAINER21_UNIT_SIZE;
-        container->unitCount = CONTAINER21_UNIT_COUNT;
-        break;
-    case 22:
-        container->unitSize = CONTAINER22_UNIT_SIZE;
-        container->unitCount = CONTAINER22_UNIT_COUNT;
-        break;
-    case 23:
-        container->unitSize = CONTAINER23_UNIT_SIZE;
-        container->unitCount = CONTAINER23_UNIT_COUNT;
-        break;
-
-    case 24:
-        container->unitSize = CONTAINER24_UNIT_SIZE;
-        container->unitCount = CONTAINER24_UNIT_COUNT;
-        break;
-    case 25:
-        container->unitSize = CONTAINER25_UNIT_SIZE;
-        container->unitCount = CONTAINER25_UNIT_COUNT;
-        break;
-    case 26:
-        container->unitSize = CONTAINER26_UNIT_SIZE;
-        container->unitCount = CONTAINER26_UNIT_COUNT;
-        break;
-    case 27:
-        container->unitSize = CONTAINER27_UNIT_SIZE;
-        container->unitCount = CONTAINER27_UNIT_COUNT;
-        break;
-    case 28:
-        container->unitSize = CONTAINER28_UNIT_SIZE;
-        container->unitCount = CONTAINER28_UNIT_COUNT;
-        break;
-    case 29:
-        container->unitSize = CONTAINER29_UNIT_SIZE;
-        container->unitCount = CONTAINER29_UNIT_COUNT;
-        break;
-    case 30:
-        container->unitSize = CONTAINER30_UNIT_SIZE;
-        container->unitCount = CONTAINER30_UNIT_COUNT;
-        break;
-    case 31:
-        container->unitSize = CONTAINER31_UNIT_SIZE;
-        container->unitCount = CONTAINER31_UNIT_COUNT;
-        break;
-    }
+    return (uint8_t *)pointer >= lcm->memBase && (uint8_t *)pointer < lcm->memEnd;
 }
 
 #ifdef __cplusplus
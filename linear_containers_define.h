@@ -42,7 +42,7 @@ extern "C" {
 #define CTN30_SZ    (2ULL * CTN29_SZ)
 #define CTN31_SZ    (2ULL * CTN30_SZ)
 
-/*容器数量*/
+/*LCMInit使用的默认容器数量，运行时配置见LCMInitWithConfig。*/
 #define CONTAINER_SIZE          6
 
 /*各容器内存单元尺寸和数量定义。
@@ -0,0 +1,210 @@
+/*
+ * 文件：mem_arena.c
+ * 描述：多分区内存管理器。把一片内存划分为多个独立的内存管理器，
+ *      线程按CPU编号或线程散列绑定到分区，不同分区之间没有竞争。
+ *      释放时根据地址直接计算出所属分区，分区扩展得到的区域中的地址通过区域表查找。
+ *      需要定义MEM_MAN_THREAD_SAFE，多个线程可能同时使用同一个分区，分区内存管理器需要加锁。
+ * 作者：Li Rongjin
+ * 日期：2026-10-16
+ **/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /*sched_getcpu*/
+#endif
+
+#include "mem_arena.h"
+#include "stdint.h"
+#include "errno.h"
+#include "stdio.h"
+#ifdef __linux__
+#include "sched.h"
+#endif
+
+#ifndef MEM_MAN_THREAD_SAFE
+#error "mem_arena.c requires MEM_MAN_THREAD_SAFE"
+#endif
+
+/*每个线程绑定的分区编号加1，为0表示尚未绑定。*/
+static CPL_THREAD_LOCAL unsigned int maThreadSlot;
+
+/*
+ * 功能：初始化多分区内存管理器
+ * buf: 管理的内存基地址
+ * size: 管理的内存尺寸
+ * arenaCount: 分区数量，不超过MA_MAX_ARENAS
+ * bindMode: 线程与分区的绑定方式
+ * config: 每个分区的内存管理器配置，可以为NULL
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+int MAInit(MemArenas *ma, uint8_t *buf, size_t size, unsigned int arenaCount,
+           int bindMode, const MMConfig *config)
+{
+    size_t offset, headSize;
+    unsigned int i;
+    uint8_t *slice;
+    int error;
+
+    if (!ma || !buf || arenaCount == 0 || arenaCount > MA_MAX_ARENAS
+            || (bindMode != MA_BIND_CPU && bindMode != MA_BIND_THREAD))
+        return -EINVAL;
+
+    /*起始地址按MA_SLICE_ALIGN对齐，每个分区的尺寸是MA_SLICE_ALIGN的整数倍。*/
+    offset = (MA_SLICE_ALIGN - (size_t)buf % MA_SLICE_ALIGN) % MA_SLICE_ALIGN;
+    if (size <= offset)
+        return -EINVAL;
+    ma->base = buf + offset;
+    ma->sliceSize = (size - offset) / arenaCount / MA_SLICE_ALIGN * MA_SLICE_ALIGN;
+    headSize = (sizeof (MemMan) + MA_SLICE_ALIGN - 1) / MA_SLICE_ALIGN * MA_SLICE_ALIGN;
+    if (ma->sliceSize <= headSize)
+        return -EINVAL;
+    ma->arenaCount = arenaCount;
+    ma->bindMode = bindMode;
+
+    for (i = 0; i < arenaCount; i++) {
+        ma->remote[i].head = NULL;
+        slice = ma->base + (size_t)i * ma->sliceSize;
+        ma->arenas[i] = (MemMan *)slice;
+        error = MMInitWithConfig(ma->arenas[i], slice + headSize, ma->sliceSize - headSize, config);
+        if (error != -ENOERR)
+            return error;
+    }
+    return 0;
+}
+
+/*
+ * 功能：选择当前线程使用的分区
+ * 返回值：分区编号。
+ */
+static unsigned int MASelectArena(MemArenas *ma)
+{
+#ifdef __linux__
+    int cpu;
+
+    if (ma->bindMode == MA_BIND_CPU) {
+        cpu = sched_getcpu();
+        if (cpu >= 0)
+            return (unsigned int)cpu % ma->arenaCount;
+    }
+#endif
+    if (maThreadSlot == 0) {
+        /*按线程局部变量的地址散列，同一线程始终得到相同的结果。*/
+        maThreadSlot = (unsigned int)((((size_t)&maThreadSlot >> 6) * 2654435761u) >> 8) + 1;
+    }
+    return (maThreadSlot - 1) % ma->arenaCount;
+}
+
+/*
+ * 功能：根据地址获取其所属分区的编号。分区缓冲区之外的地址来自分区扩展得到的区域，
+ *      通过各分区动态容器的区域表查找。
+ * 返回值：成功时返回0，地址不属于任何分区时返回错误码。
+ */
+static int MAGetArenaId(MemArenas *ma, void *pointer, unsigned int *pId)
+{
+    size_t idx;
+    unsigned int i;
+
+    if ((uint8_t *)pointer >= ma->base) {
+        idx = ((uint8_t *)pointer - ma->base) / ma->sliceSize;
+        if (idx < ma->arenaCount) {
+            *pId = (unsigned int)idx;
+            return 0;
+        }
+    }
+    for (i = 0; i < ma->arenaCount; i++) {
+        if (DCMIsOwner(&ma->arenas[i]->dcm, pointer)) {
+            *pId = i;
+            return 0;
+        }
+    }
+    return -EINVAL;
+}
+
+/*
+ * 功能：根据地址获取其所属分区的内存管理器
+ * 返回值：内存管理器指针，地址不属于任何分区时返回NULL。
+ */
+MemMan *MAGetArena(MemArenas *ma, void *pointer)
+{
+    unsigned int id;
+
+    if (MAGetArenaId(ma, pointer, &id) != -ENOERR)
+        return NULL;
+    return ma->arenas[id];
+}
+
+/*
+ * 功能：取出分区远程释放队列中的全部内存并释放到该分区。
+ *      队列只在这里被整体取走，因此压入时不存在ABA问题。
+ * 返回值：无。
+ */
+static void MADrainArena(MemArenas *ma, unsigned int id)
+{
+    void *p, *next;
+
+    if (!CplAtomicLoad(&ma->remote[id].head))
+        return;
+    p = CplAtomicExchange(&ma->remote[id].head, (void *)NULL);
+    for (; p; p = next) {
+        next = *(void **)p;
+        MMFree(ma->arenas[id], p);
+    }
+}
+
+/*
+ * 功能：释放所有分区远程释放队列中的内存，用于长时间没有分配操作的分区。
+ * 返回值：无。
+ */
+void MADrain(MemArenas *ma)
+{
+    unsigned int i;
+
+    for (i = 0; i < ma->arenaCount; i++)
+        MADrainArena(ma, i);
+}
+
+/*
+ * 功能：从当前线程绑定的分区申请size大小的内存，该分区内存不足时依次尝试其他分区。
+ *      分配前先处理分区的远程释放队列。
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+void *MAAlloc(MemArenas *ma, size_t size)
+{
+    unsigned int start, id, i;
+    void *p;
+
+    start = MASelectArena(ma);
+    for (i = 0; i < ma->arenaCount; i++) {
+        id = (start + i) % ma->arenaCount;
+        MADrainArena(ma, id);
+        p = MMAlloc(ma->arenas[id], size);
+        if (p)
+            return p;
+    }
+    return NULL;
+}
+
+/*
+ * 功能：释放内存，内存被归还到分配它的分区。
+ *      内存不属于当前线程绑定的分区时，只做一次原子操作压入所属分区的远程释放队列。
+ * 返回值：无。
+ */
+void MAFree(MemArenas *ma, void *pointer)
+{
+    unsigned int id;
+    void *head;
+
+    if (!pointer)
+        return;
+    if (MAGetArenaId(ma, pointer, &id) != -ENOERR) {
+        printf("pointer [%p(H)] does not belong to any arena\n", pointer);
+        return;
+    }
+    if (id == MASelectArena(ma)) {
+        MMFree(ma->arenas[id], pointer);
+        return;
+    }
+    head = CplAtomicLoad(&ma->remote[id].head);
+    do {
+        *(void **)pointer = head;
+    } while (!CplAtomicCas(&ma->remote[id].head, &head, pointer));
+}
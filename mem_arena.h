@@ -0,0 +1,49 @@
+#ifndef __MEM_ARENA_H__
+#define __MEM_ARENA_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mem_man.h"
+
+/*分区数量上限*/
+#define MA_MAX_ARENAS           64
+
+/*线程与分区的绑定方式*/
+#define MA_BIND_CPU             0   /*按线程当前运行的CPU编号选择分区，不支持时退化为按线程散列*/
+#define MA_BIND_THREAD          1   /*按线程散列选择分区，线程始终使用同一个分区*/
+
+/*分区首部对齐尺寸，使每个分区的管理数据结构独占缓存行。*/
+#define MA_SLICE_ALIGN          64
+
+/*远程释放队列。其他线程释放的内存无锁地压入所属分区的队列，
+    由该分区的线程在下次分配时批量取出并释放。*/
+typedef struct {
+    void *head;     /*队列头，内存块首部保存下一个内存块的地址*/
+    uint8_t pad[MA_SLICE_ALIGN - sizeof (void *)];
+} MARemoteQueue;
+
+/*多分区内存管理器。缓冲区被平均划分为若干分区，每个分区是一个独立的内存管理器，
+    分区的管理数据结构放在分区的首部。*/
+typedef struct _MemArenas {
+    MemMan *arenas[MA_MAX_ARENAS];  /*各分区的内存管理器*/
+    unsigned int arenaCount;        /*分区数量*/
+    int bindMode;                   /*线程与分区的绑定方式，MA_BIND_XXX*/
+    uint8_t *base;                  /*第一个分区的起始地址*/
+    size_t sliceSize;               /*每个分区的尺寸*/
+    MARemoteQueue remote[MA_MAX_ARENAS];    /*各分区的远程释放队列*/
+} MemArenas;
+
+int MAInit(MemArenas *ma, uint8_t *buf, size_t size, unsigned int arenaCount,
+           int bindMode, const MMConfig *config);
+void *MAAlloc(MemArenas *ma, size_t size);
+void MAFree(MemArenas *ma, void *pointer);
+MemMan *MAGetArena(MemArenas *ma, void *pointer);
+void MADrain(MemArenas *ma);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MEM_ARENA_H__*/
@@ -10,6 +10,11 @@
 
 #include "mem_man.h"
 #include "stdio.h"
+#include "string.h"
+#include "stdlib.h"
+#ifdef MEM_MAN_THREAD_SAFE
+#include "time.h"
+#endif
 
 /*
  * 功能：内存管理器初始化
@@ -17,13 +22,48 @@
  * size: 内存管理器管理的内存尺寸
  * 返回值：成功时返回0，否则返回错误码。
  */
-int MMInit(MemMan *memMan, uint8_t *buf, unsigned int size)
+int MMInit(MemMan *memMan, uint8_t *buf, size_t size)
 {
-    unsigned int remain = 0;
+    return MMInitWithConfig(memMan, buf, size, NULL);
+}
+
+/*
+ * 功能：按照运行时配置初始化内存管理器
+ * buf: 内存管理器管理的内存基地址
+ * size: 内存管理器管理的内存尺寸
+ * config: 内存管理器配置，为NULL时使用默认配置
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+int MMInitWithConfig(MemMan *memMan, uint8_t *buf, size_t size, const MMConfig *config)
+{
+    size_t remain = 0;
     int error1, error2;
 
-    error1 = LCMInit(&memMan->lcm, buf, size, &remain);
-    error2 = DCMInit(&memMan->dcm, &buf[size-remain], remain);
+    if (config && config->classes) {
+        error1 = LCMInitWithConfig(&memMan->lcm, buf, size, &remain,
+                                   config->classes, config->classCount);
+    } else {
+        error1 = LCMInit(&memMan->lcm, buf, size, &remain);
+    }
+    if (config && config->zeroed) {
+        memMan->lcm.zeroed = 1;
+        error2 = DCMInitWithFlags(&memMan->dcm, &buf[size-remain], remain, DCM_FLAG_ZEROED);
+    } else {
+        error2 = DCMInit(&memMan->dcm, &buf[size-remain], remain);
+    }
+    if (config && config->grow) {
+        DCMSetGrowFunc(&memMan->dcm, config->grow, config->growArg, config->growFlags);
+        /*可以自动扩展时，剩余内存不足以构成初始区域也能正常使用。*/
+        if (error2 == -EINVAL)
+            error2 = -ENOERR;
+    }
+    if (config && (config->purgeMinSize || config->purgeThreshold))
+        DCMSetPurge(&memMan->dcm, config->purgeMinSize, config->purgeThreshold);
+    memMan->tcacheDepth = (config && config->tcacheDepth) ? config->tcacheDepth : MM_TCACHE_DEFAULT_DEPTH;
+    memMan->region = NULL;
+    memMan->regionCur = NULL;
+    memMan->regionEnd = NULL;
+    memMan->regionLarge = NULL;
     if (error1 == -ENOERR &&
             error2 == -ENOERR)
         return 0;
@@ -31,6 +71,192 @@ int MMInit(MemMan *memMan, uint8_t *buf, unsigned int size)
         return -EINVAL;
 }
 
+#ifdef MEM_MAN_TCACHE
+/*线程缓存，空闲内存单元通过其首部的指针串成链表。
+ *内存单元不小于两个指针时，第二个指针保存缓存地址作为标记，用于发现重复释放。*/
+typedef struct {
+    MemMan *owner;                          /*缓存所属的内存管理器*/
+    unsigned int total;                     /*缓存的内存单元总数*/
+    unsigned int count[LCM_MAX_CONTAINERS]; /*每个容器缓存的内存单元数量*/
+    void *head[LCM_MAX_CONTAINERS];         /*每个容器缓存的链表头*/
+} MMThreadCache;
+
+static CPL_THREAD_LOCAL MMThreadCache mmTCache;
+
+/*内存单元中保存标记的位置，单元太小时为NULL。*/
+#define MM_TCACHE_KEY(unit, unitSize)   ((unitSize) >= 2 * sizeof (void *) ? (void **)(unit) + 1 : NULL)
+
+/*
+ * 功能：获取当前线程可用于memMan的缓存。缓存为空时绑定到memMan，
+ *      缓存中还有其他管理器的内存时不使用缓存。
+ * 返回值：缓存指针或NULL。
+ */
+static MMThreadCache *MMTCacheGet(MemMan *memMan)
+{
+    MMThreadCache *tc = &mmTCache;
+
+    if (memMan->tcacheDepth == 0)
+        return NULL;
+    if (tc->owner != memMan) {
+        if (tc->total != 0)
+            return NULL;
+        tc->owner = memMan;
+    }
+    return tc;
+}
+
+/*
+ * 功能：把缓存中编号为ctnId的容器的n个内存单元归还给线性容器管理器。
+ * 返回值：无。
+ */
+static void MMTCacheRelease(MMThreadCache *tc, unsigned int ctnId, unsigned int n)
+{
+    void *batch[MM_TCACHE_DEFAULT_DEPTH];
+    unsigned int unitSize = tc->owner->lcm.containers[ctnId].unitSize;
+    unsigned int k;
+    void **key;
+
+    while (n > 0 && tc->head[ctnId]) {
+        for (k = 0; k < ARRAY_SIZE(batch) && k < n && tc->head[ctnId]; k++) {
+            batch[k] = tc->head[ctnId];
+            tc->head[ctnId] = *(void **)batch[k];
+            key = MM_TCACHE_KEY(batch[k], unitSize);
+            if (key)
+                *key = NULL;
+        }
+        LCMFreeBulk(&tc->owner->lcm, ctnId, batch, k);
+        tc->count[ctnId] -= k;
+        tc->total -= k;
+        n -= k;
+    }
+}
+
+/*
+ * 功能：从线程缓存分配内存，缓存为空时从线性容器管理器批量补充半个缓存深度的内存单元。
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+static void *MMTCacheAlloc(MemMan *memMan, size_t size)
+{
+    void *batch[MM_TCACHE_DEFAULT_DEPTH];
+    MMThreadCache *tc;
+    unsigned int ctnId, unitSize, n, k;
+    void **key;
+    void *p;
+
+    tc = MMTCacheGet(memMan);
+    if (!tc || LCMSizeToClass(&memMan->lcm, size, &ctnId) != -ENOERR)
+        return NULL;
+    unitSize = memMan->lcm.containers[ctnId].unitSize;
+    p = tc->head[ctnId];
+    if (p) {
+        tc->head[ctnId] = *(void **)p;
+        tc->count[ctnId]--;
+        tc->total--;
+        key = MM_TCACHE_KEY(p, unitSize);
+        if (key)
+            *key = NULL;
+        return p;
+    }
+    n = memMan->tcacheDepth / 2 + 1;
+    if (n > ARRAY_SIZE(batch))
+        n = ARRAY_SIZE(batch);
+    n = LCMAllocBulk(&memMan->lcm, ctnId, batch, n);
+    if (n == 0)
+        return NULL;
+    for (k = 1; k < n; k++) {
+        *(void **)batch[k] = tc->head[ctnId];
+        tc->head[ctnId] = batch[k];
+        key = MM_TCACHE_KEY(batch[k], unitSize);
+        if (key)
+            *key = tc;
+    }
+    tc->count[ctnId] += n - 1;
+    tc->total += n - 1;
+    return batch[0];
+}
+
+/*
+ * 功能：判断内存单元是否已经在线程缓存中。单元中有标记时遍历链表确认，
+ *      避免用户数据恰好等于标记时误判；单元太小时只能发现与链表头相同的重复释放。
+ * 返回值：在缓存中返回1，否则返回0。
+ */
+static char MMTCacheContains(MMThreadCache *tc, unsigned int ctnId, void *unit, unsigned int unitSize)
+{
+    void **key = MM_TCACHE_KEY(unit, unitSize);
+    void *p;
+
+    if (unit == tc->head[ctnId])
+        return 1;
+    if (!key || *key != tc)
+        return 0;
+    for (p = tc->head[ctnId]; p; p = *(void **)p) {
+        if (p == unit)
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * 功能：把线性容器管理器中的内存放回线程缓存，缓存超过深度时归还一半。
+ *      已经在缓存中的内存单元被重复释放时直接忽略，与线性容器忽略重复释放的行为一致。
+ * 返回值：成功放入缓存或忽略重复释放时返回1，否则返回0。
+ */
+static char MMTCacheFree(MemMan *memMan, void *pointer)
+{
+    MMThreadCache *tc;
+    unsigned int ctnId, unitId;
+    LCMLinearContainer *container;
+    void **key;
+
+    tc = MMTCacheGet(memMan);
+    if (!tc || LCMLookup(&memMan->lcm, pointer, &ctnId, &unitId) != -ENOERR)
+        return 0;
+    container = &memMan->lcm.containers[ctnId];
+    pointer = container->base + (size_t)unitId * container->unitSize;
+    if (MMTCacheContains(tc, ctnId, pointer, container->unitSize))
+        return 1;
+    key = MM_TCACHE_KEY(pointer, container->unitSize);
+    if (key)
+        *key = tc;
+    *(void **)pointer = tc->head[ctnId];
+    tc->head[ctnId] = pointer;
+    tc->count[ctnId]++;
+    tc->total++;
+    if (tc->count[ctnId] > memMan->tcacheDepth)
+        MMTCacheRelease(tc, ctnId, tc->count[ctnId] - memMan->tcacheDepth / 2);
+    return 1;
+}
+#endif
+
+/*
+ * 功能：把当前线程缓存的内存全部归还给memMan，线程退出前需要调用。
+ * 返回值：无。
+ */
+void MMTCacheFlush(MemMan *memMan)
+{
+#ifdef MEM_MAN_TCACHE
+    MMThreadCache *tc = &mmTCache;
+    unsigned int u;
+
+    if (tc->owner != memMan)
+        return;
+    for (u = 0; u < LCM_MAX_CONTAINERS; u++)
+        MMTCacheRelease(tc, u, tc->count[u]);
+    tc->owner = NULL;
+#else
+    (void)memMan;
+#endif
+}
+
+/*
+ * 功能：设置线程缓存深度，为0时不使用线程缓存。减小深度后多余的内存在各线程下次释放时归还。
+ * 返回值：无。
+ */
+void MMSetTCacheDepth(MemMan *memMan, unsigned int depth)
+{
+    memMan->tcacheDepth = depth;
+}
+
 /*
  * 功能：申请size大小的一块内存
  * 返回值：成功时返回有效的被分配内存首地址，否则返回NULL。
@@ -39,6 +265,11 @@ void *MMAlloc(MemMan *memMan, size_t size)
 {
     void *p;
 
+#ifdef MEM_MAN_TCACHE
+    p = MMTCacheAlloc(memMan, size);
+    if (p)
+        return p;
+#endif
     p = LCMAlloc(&memMan->lcm, size);
     if (!p)
         return DCMAlloc(&memMan->dcm, size);
@@ -51,13 +282,282 @@ void *MMAlloc(MemMan *memMan, size_t size)
  */
 void MMFree(MemMan *memMan, void *pointer)
 {
-    uint8_t *addr = pointer;
-
-    if (addr >= memMan->dcm.memBase) {
+    if (LCMIsOwner(&memMan->lcm, pointer)) {
+#ifdef MEM_MAN_TCACHE
+        if (MMTCacheFree(memMan, pointer))
+            return;
+#endif
+        LCMFree(&memMan->lcm, pointer);
+    } else {
         DCMFree(&memMan->dcm, pointer);
+    }
+}
+
+/*
+ * 功能：一次申请最多n个size大小的内存。优先由size所属的线性容器按位图字批量分配，
+ *      不足的部分由动态容器从一个大块中切分，不经过线程缓存。
+ * out: 保存分配到的地址指针
+ * 返回值：分配到的内存数量
+ */
+unsigned int MMAllocBatch(MemMan *memMan, size_t size, unsigned int n, void **out)
+{
+    unsigned int ctnId, k = 0;
+
+    if (LCMSizeToClass(&memMan->lcm, size, &ctnId) == -ENOERR)
+        k = LCMAllocBulk(&memMan->lcm, ctnId, out, n);
+    if (k < n)
+        k += DCMAllocBatch(&memMan->dcm, size, out + k, n - k);
+    return k;
+}
+
+/*
+ * 功能：比较两个地址指针，用于按地址升序排序。
+ * 返回值：a小于、等于、大于b时分别返回负数、0、正数。
+ */
+static int MMPointerCompare(const void *a, const void *b)
+{
+    uintptr_t pa = (uintptr_t)*(void * const *)a, pb = (uintptr_t)*(void * const *)b;
+
+    return (pa > pb) - (pa < pb);
+}
+
+/*
+ * 功能：一次释放ptrs中的n个内存空间，NULL被忽略。先按地址排序，同一个线性容器中的
+ *      内存单元只获取一次容器锁，其余内存一次交给动态容器释放，不经过线程缓存。
+ *      排序会改变ptrs中指针的顺序。
+ * 返回值：无。
+ */
+void MMFreeBatch(MemMan *memMan, void **ptrs, unsigned int n)
+{
+    LCMLinearContainer *container;
+    unsigned int i, j, d, ctnId, unitId;
+    uint8_t *end;
+
+    qsort(ptrs, n, sizeof (ptrs[0]), MMPointerCompare);
+    /*排序后NULL位于最前面，线性容器中的指针按容器聚集，其余指针前移后交给动态容器。*/
+    for (i = d = 0; i < n; i = j) {
+        j = i + 1;
+        if (!ptrs[i])
+            continue;
+        if (!LCMIsOwner(&memMan->lcm, ptrs[i])) {
+            ptrs[d++] = ptrs[i];
+            continue;
+        }
+        if (LCMLookup(&memMan->lcm, ptrs[i], &ctnId, &unitId) != -ENOERR)
+            continue;
+        container = &memMan->lcm.containers[ctnId];
+        end = container->base + (size_t)container->unitCount * container->unitSize;
+        while (j < n && (uint8_t *)ptrs[j] < end)
+            j++;
+        LCMFreeBulk(&memMan->lcm, ctnId, &ptrs[i], j - i);
+    }
+    if (d)
+        DCMFreeBatch(&memMan->dcm, ptrs, d);
+}
+
+/*区域分配的内存块头部，内存块通过prev串成链表，最新的内存块位于链表头部。*/
+typedef struct _MMRegionBlock {
+    struct _MMRegionBlock *prev;    /*上一个内存块*/
+    uint8_t *end;                   /*内存块的结束地址*/
+} MMRegionBlock;
+
+/*
+ * 功能：以区域方式申请size大小的内存：在当前内存块中顺序分配，不足时从动态容器获取新的内存块。
+ *      超过MM_REGION_LARGE_SIZE的请求单独获取一块，不替换当前内存块。
+ *      区域分配的内存不能通过MMFree释放，由MMRelease或MMReset统一释放。区域分配不加锁，
+ *      同一个内存管理器的区域分配、MMMark和MMRelease只能由一个线程调用。
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+void *MMRegionAlloc(MemMan *memMan, size_t size)
+{
+    MMRegionBlock *block;
+    uint8_t *p;
+
+    if (size > (size_t)-1 - sizeof (MMRegionBlock) - MEM_MAN_ALIGN_SIZE)
+        return NULL;
+    size = (size + MEM_MAN_ALIGN_SIZE - 1) / MEM_MAN_ALIGN_SIZE * MEM_MAN_ALIGN_SIZE;
+    if (memMan->region && size <= (size_t)(memMan->regionEnd - memMan->regionCur)) {
+        p = memMan->regionCur;
+        memMan->regionCur += size;
+        return p;
+    }
+    if (size > MM_REGION_LARGE_SIZE) {
+        block = DCMAlloc(&memMan->dcm, sizeof (MMRegionBlock) + size);
+        if (!block)
+            return NULL;
+        block->prev = memMan->regionLarge;
+        block->end = (uint8_t *)(block + 1) + size;
+        memMan->regionLarge = block;
+        return block + 1;
+    }
+    /*当前内存块的剩余部分不足MM_REGION_LARGE_SIZE，不再使用。*/
+    block = DCMAlloc(&memMan->dcm, MM_REGION_BLOCK_SIZE);
+    if (!block)
+        return NULL;
+    block->prev = memMan->region;
+    block->end = (uint8_t *)block + MM_REGION_BLOCK_SIZE;
+    p = (uint8_t *)(block + 1);
+    memMan->region = block;
+    memMan->regionCur = p + size;
+    memMan->regionEnd = block->end;
+    return p;
+}
+
+/*
+ * 功能：记录当前的区域分配位置。
+ * 返回值：无。
+ */
+void MMMark(MemMan *memMan, MMMarker *mark)
+{
+    mark->block = memMan->region;
+    mark->cur = memMan->regionCur;
+    mark->large = memMan->regionLarge;
+}
+
+/*
+ * 功能：释放mark之后的所有区域分配：把之后获取的内存块和大块还给动态容器，并把分配位置恢复到mark。
+ *      mark之后记录的标记随之失效。
+ * 返回值：无。
+ */
+void MMRelease(MemMan *memMan, const MMMarker *mark)
+{
+    MMRegionBlock *block;
+
+    while (memMan->regionLarge && memMan->regionLarge != mark->large) {
+        block = memMan->regionLarge;
+        memMan->regionLarge = block->prev;
+        DCMFree(&memMan->dcm, block);
+    }
+    while (memMan->region && memMan->region != mark->block) {
+        block = memMan->region;
+        memMan->region = block->prev;
+        DCMFree(&memMan->dcm, block);
+    }
+    if (memMan->region) {
+        memMan->regionCur = mark->cur;
+        memMan->regionEnd = ((MMRegionBlock *)memMan->region)->end;
     } else {
-        LCMFree(&memMan->lcm, pointer);
+        memMan->regionCur = NULL;
+        memMan->regionEnd = NULL;
+    }
+}
+
+/*
+ * 功能：一次释放内存管理器中的所有内存，包括区域分配和通过MMAlloc等接口分配的内存。
+ *      不遍历已分配的内存：线性容器只清除曾经使用过的元数据，动态容器的每个区域直接恢复为一个空闲块。
+ *      调用时不能有其他线程同时访问memMan，其他线程的线程缓存需要事先通过MMTCacheFlush归还。
+ * 返回值：无。
+ */
+void MMReset(MemMan *memMan)
+{
+#ifdef MEM_MAN_TCACHE
+    /*当前线程缓存的内存单元随管理器一起释放，直接丢弃。*/
+    if (mmTCache.owner == memMan)
+        memset(&mmTCache, 0, sizeof (mmTCache));
+#endif
+    LCMReset(&memMan->lcm);
+    DCMReset(&memMan->dcm);
+    memMan->region = NULL;
+    memMan->regionCur = NULL;
+    memMan->regionEnd = NULL;
+    memMan->regionLarge = NULL;
+}
+
+/*
+ * 功能：申请size大小、按align对齐的内存。优先从内存单元满足对齐要求的线性容器中分配，
+ *      否则从动态容器中切分对齐的区域。
+ * align: 对齐尺寸，需要是2的幂
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+void *MMAllocAligned(MemMan *memMan, size_t size, size_t align)
+{
+    void *p;
+
+    if (!align || (align & (align - 1)))
+        return NULL;
+    if (align <= MEM_MAN_ALIGN_SIZE)
+        return MMAlloc(memMan, size);
+    p = LCMAllocAligned(&memMan->lcm, size, align);
+    if (!p)
+        return DCMAllocAligned(&memMan->dcm, size, align);
+    return p;
+}
+
+/*
+ * 功能：向内存管理器添加一段内存，由动态容器管理。
+ * flags: DCM_FLAG_XXX，例如内存内容全为0时为DCM_FLAG_ZEROED
+ * 返回值：成功时返回0，否则返回错误码。
+ */
+int MMAddRegion(MemMan *memMan, uint8_t *buf, size_t size, unsigned int flags)
+{
+    return DCMAddRegion(&memMan->dcm, buf, size, flags);
+}
+
+/*
+ * 功能：把动态容器中可归还区域（DCM_FLAG_PURGEABLE）的大空闲块占用的物理页还给系统。
+ *      线性容器的内存单元较小，不归还。
+ * 返回值：归还的字节数
+ */
+size_t MMPurge(MemMan *memMan)
+{
+    return DCMPurge(&memMan->dcm);
+}
+
+/*
+ * 功能：申请count个size大小并清零的内存。管理的内存初始全为0时（见MMConfig.zeroed），
+ *      只清零被使用过的部分。
+ * 返回值：成功时返回地址指针，否则返回NULL。
+ */
+void *MMCalloc(MemMan *memMan, size_t count, size_t size)
+{
+    void *p;
+
+    if (size && count > (size_t)-1 / size)
+        return NULL;
+    size *= count;
+    p = LCMCalloc(&memMan->lcm, size);
+    if (!p)
+        return DCMCalloc(&memMan->dcm, size);
+    return p;
+}
+
+/*
+ * 功能：调整pointer指向的内存空间的尺寸。pointer为NULL时等同于MMAlloc，size为0时等同于MMFree并返回NULL。
+ *      线性容器中的内存单元仍能容纳size时直接复用；动态容器中的块优先原地缩小或扩大。
+ * 返回值：成功时返回调整后的地址指针，否则返回NULL，原有内存空间不变。
+ */
+void *MMRealloc(MemMan *memMan, void *pointer, size_t size)
+{
+    LCMLinearContainer *container;
+    unsigned int ctnId, unitId;
+    size_t usable;
+    void *p;
+
+    if (!pointer)
+        return MMAlloc(memMan, size);
+    if (size == 0) {
+        MMFree(memMan, pointer);
+        return NULL;
     }
+
+    /*DCMRealloc无法原地调整时已经在动态容器中重新分配并复制，失败时不再重试。*/
+    if (!LCMIsOwner(&memMan->lcm, pointer))
+        return DCMRealloc(&memMan->dcm, pointer, size);
+
+    if (LCMLookup(&memMan->lcm, pointer, &ctnId, &unitId) != 0)
+        return NULL;
+    container = &memMan->lcm.containers[ctnId];
+    usable = container->base + (size_t)(unitId + 1) * container->unitSize - (uint8_t *)pointer;
+    if (size <= usable)
+        return pointer;
+
+    /*线性容器中的内存单元无法容纳时重新分配内存，新的内存可能来自另一个管理器。*/
+    p = MMAlloc(memMan, size);
+    if (!p)
+        return NULL;
+    memcpy(p, pointer, usable < size ? usable : size);
+    MMFree(memMan, pointer);
+    return p;
 }
 
 void MMExample(void)
@@ -73,3 +573,79 @@ void MMExample(void)
     LCMPrint(&man.lcm);
     DCMPrint(&man.dcm);
 }
+
+#ifdef MEM_MAN_THREAD_SAFE
+#define MM_BENCH_MAX_THREADS    8
+#define MM_BENCH_BATCH          64
+#define MM_BENCH_ROUNDS         20000
+
+typedef struct {
+    MemMan *memMan;
+    size_t size;
+} MMBenchArg;
+
+static void *MMBenchThread(void *param)
+{
+    MMBenchArg *arg = param;
+    void *p[MM_BENCH_BATCH];
+    unsigned int r, i;
+
+    for (r = 0; r < MM_BENCH_ROUNDS; r++) {
+        for (i = 0; i < MM_BENCH_BATCH; i++)
+            p[i] = MMAlloc(arg->memMan, arg->size);
+        for (i = 0; i < MM_BENCH_BATCH; i++)
+            MMFree(arg->memMan, p[i]);
+    }
+    MMTCacheFlush(arg->memMan);
+    return NULL;
+}
+
+/*
+ * 功能：多线程扩展性测试，分别测试1到MM_BENCH_MAX_THREADS个线程在各自使用不同尺寸等级
+ *      和共用同一尺寸等级时的分配吞吐量。
+ * 返回值：无。
+ */
+void MMThreadBenchmark(void)
+{
+    static uint8_t buf[4 * 1024 * 1024];
+    LCMClassConfig classes[MM_BENCH_MAX_THREADS];
+    MMBenchArg args[MM_BENCH_MAX_THREADS];
+    pthread_t tids[MM_BENCH_MAX_THREADS];
+    MMConfig config = {0};
+    MemMan man;
+    struct timespec t0, t1;
+    unsigned int n, t, shared;
+    double sec;
+
+    for (t = 0; t < MM_BENCH_MAX_THREADS; t++) {
+        classes[t].unitSize = 16 * (t + 1);
+        classes[t].unitCount = MM_BENCH_BATCH * MM_BENCH_MAX_THREADS;
+        classes[t].mode = LCM_DEFAULT_MODE;
+        classes[t].align = 0;
+    }
+    config.classes = classes;
+    config.classCount = MM_BENCH_MAX_THREADS;
+
+    printf("threads  class     Mops/s\n");
+    for (shared = 0; shared < 2; shared++) {
+        for (n = 1; n <= MM_BENCH_MAX_THREADS; n++) {
+            if (MMInitWithConfig(&man, buf, sizeof (buf), &config) != 0) {
+                printf("init memory manager failed\n");
+                return;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            for (t = 0; t < n; t++) {
+                args[t].memMan = &man;
+                args[t].size = shared ? classes[0].unitSize : classes[t].unitSize;
+                pthread_create(&tids[t], NULL, MMBenchThread, &args[t]);
+            }
+            for (t = 0; t < n; t++)
+                pthread_join(tids[t], NULL);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+            printf("%7u  %-6s  %9.2f\n", n, shared ? "shared" : "own",
+                   2.0 * n * MM_BENCH_ROUNDS * MM_BENCH_BATCH / sec / 1e6);
+        }
+    }
+}
+#endif
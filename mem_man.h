@@ -20,15 +20,66 @@ extern "C" {
 /*地址对齐尺寸*/
 #define MEM_MAN_ALIGN_SIZE      (8)
 
+/*定义后在MMAlloc/MMFree之前增加线程缓存，每个线程为每个线性容器缓存若干空闲内存单元，
+    线程释放的内存优先放回自己的缓存，分配时优先从缓存获取，不访问共享的管理器。*/
+//#define MEM_MAN_TCACHE
+
+/*线程缓存中每个容器默认的缓存深度*/
+#define MM_TCACHE_DEFAULT_DEPTH     32
+
+/*区域分配每次从动态容器获取的内存块尺寸*/
+#define MM_REGION_BLOCK_SIZE        (64 * 1024)
+/*超过该尺寸的区域分配单独从动态容器获取一块，当前内存块保持不变。*/
+#define MM_REGION_LARGE_SIZE        (MM_REGION_BLOCK_SIZE / 4)
+
 /*内存管理数据结构*/
 typedef struct _MemMan {
     LinearContainerMan lcm; /*线性容器管理器*/
     DynamicCtnMan dcm;      /*动态容器管理器*/
+    unsigned int tcacheDepth;   /*线程缓存中每个容器最多缓存的内存单元数量，0表示不使用线程缓存*/
+    void *region;           /*区域分配当前使用的内存块，为NULL时没有内存块*/
+    uint8_t *regionCur;     /*当前内存块中下一次区域分配的地址*/
+    uint8_t *regionEnd;     /*当前内存块的结束地址*/
+    void *regionLarge;      /*区域分配中单独获取的大块，最新的位于链表头部*/
 } MemMan;
 
-int MMInit(MemMan *memMan, uint8_t *buf, unsigned int size);
+/*区域分配的位置标记，MMRelease释放MMMark之后的所有区域分配。*/
+typedef struct {
+    void *block;            /*标记时的内存块*/
+    uint8_t *cur;           /*标记时的分配地址*/
+    void *large;            /*标记时最新的大块*/
+} MMMarker;
+
+/*内存管理器配置*/
+typedef struct {
+    const LCMClassConfig *classes;  /*线性容器配置表，按内存单元尺寸升序排列，为NULL时使用默认配置*/
+    size_t classCount;              /*线性容器配置数量*/
+    unsigned int tcacheDepth;       /*线程缓存深度，为0时使用MM_TCACHE_DEFAULT_DEPTH*/
+    char zeroed;                    /*buf的内容是否全为0，例如刚从mmap获得的内存，MMCalloc据此跳过清零*/
+    DCMGrowFunc grow;               /*动态容器扩展堆区的回调函数，例如DCMMmapGrow或DCMHugePageGrow，为NULL时不自动扩展*/
+    void *growArg;                  /*传给扩展回调的参数*/
+    unsigned int growFlags;         /*扩展回调返回的内存的DCM_FLAG_XXX，使用DCMMmapGrow时可以加上DCM_FLAG_PURGEABLE*/
+    size_t purgeMinSize;            /*只归还不小于该尺寸的空闲块的物理页，为0时使用DCM_PURGE_DEFAULT_MIN_SIZE*/
+    size_t purgeThreshold;          /*释放的大块累计超过该尺寸时自动归还物理页，为0时只在调用MMPurge时归还*/
+} MMConfig;
+
+int MMInit(MemMan *memMan, uint8_t *buf, size_t size);
+int MMInitWithConfig(MemMan *memMan, uint8_t *buf, size_t size, const MMConfig *config);
 void *MMAlloc(MemMan *memMan, size_t size);
 void MMFree(MemMan *memMan, void *pointer);
+unsigned int MMAllocBatch(MemMan *memMan, size_t size, unsigned int n, void **out);
+void MMFreeBatch(MemMan *memMan, void **ptrs, unsigned int n);
+int MMAddRegion(MemMan *memMan, uint8_t *buf, size_t size, unsigned int flags);
+void *MMRealloc(MemMan *memMan, void *pointer, size_t size);
+void *MMAllocAligned(MemMan *memMan, size_t size, size_t align);
+void *MMCalloc(MemMan *memMan, size_t count, size_t size);
+size_t MMPurge(MemMan *memMan);
+void MMSetTCacheDepth(MemMan *memMan, unsigned int depth);
+void MMTCacheFlush(MemMan *memMan);
+void *MMRegionAlloc(MemMan *memMan, size_t size);
+void MMMark(MemMan *memMan, MMMarker *mark);
+void MMRelease(MemMan *memMan, const MMMarker *mark);
+void MMReset(MemMan *memMan);
 
 #ifdef __cplusplus
 }